@@ -0,0 +1,269 @@
+#include "utils.hpp"
+#include "solver.hpp"
+#include "strategies.hpp"
+#include "generator.hpp"
+#include "output_writer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// Benchmarks every phase of the pipeline on generated instances.
+// Usage: benchmark [--sizes 100,1000,...] [--kinds convex,nonconvex,grid,clustered,constrained]
+//                  [--seed N] [--threads N] [--improve-limit S] [--strategy-faces N] [--snap-bits B]
+//                  [--adaptive] [--strategy-skip P] [--no-prescreen]
+//                  [--label text] [--out results.jsonl]
+// Every measurement is one JSON object per line, so runs of different commits can be compared.
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+vector<string> splitList(const string& list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// One result line; fields are appended in order and the line is written by end()
+class ResultLine {
+public:
+    ResultLine(ostream& out, const string& label, const InputData& instance, const char* kind, const string& phase)
+        : out_(out) {
+        line_ << "{\"label\":" << jsonString(label) << ",\"instance\":" << jsonString(instance.getInstanceUid())
+              << ",\"kind\":" << jsonString(kind) << ",\"points\":" << instance.getPointsX().size()
+              << ",\"constraints\":" << instance.getAdditionalConstraints().size()
+              << ",\"phase\":" << jsonString(phase);
+    }
+    template <class T> ResultLine& field(const char* name, const T& value) {
+        line_ << ",\"" << name << "\":" << value;
+        return *this;
+    }
+    ResultLine& text(const char* name, const string& value) {
+        line_ << ",\"" << name << "\":" << jsonString(value);
+        return *this;
+    }
+    void end() {
+        out_ << line_.str() << "}" << endl;
+    }
+
+private:
+    ostream& out_;
+    ostringstream line_;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes = {100, 1000, 10000, 100000, 1000000};
+    vector<InstanceKind> kinds = {InstanceKind::Convex, InstanceKind::NonConvex, InstanceKind::Grid,
+                                  InstanceKind::Clustered, InstanceKind::Constrained};
+    uint64_t seed = 1;
+    string label;
+    string outputFile;
+    size_t strategyFaces = 10000;
+    SolverOptions options;
+    options.verbose = false;
+    options.time_limit = 30;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            for (const string& size : splitList(argv[++i])) {
+                sizes.push_back(static_cast<size_t>(atof(size.c_str())));
+            }
+        } else if (arg == "--kinds" && i + 1 < argc) {
+            kinds.clear();
+            for (const string& name : splitList(argv[++i])) {
+                InstanceKind kind;
+                if (!parseInstanceKind(name, kind)) {
+                    cerr << "Unknown instance kind: " << name << endl;
+                    return 1;
+                }
+                kinds.push_back(kind);
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else if (arg == "--improve-limit" && i + 1 < argc) {
+            options.time_limit = atof(argv[++i]);
+        } else if (arg == "--snap-bits" && i + 1 < argc) {
+            options.snap_bits = max(0, atoi(argv[++i]));
+        } else if (arg == "--adaptive") {
+            options.adaptive_strategies = true;
+        } else if (arg == "--no-prescreen") {
+            options.prescreen = false;
+        } else if (arg == "--strategy-skip" && i + 1 < argc) {
+            options.strategy_skip = atof(argv[++i]);
+        } else if (arg == "--strategy-faces" && i + 1 < argc) {
+            strategyFaces = static_cast<size_t>(atol(argv[++i]));
+        } else if (arg == "--label" && i + 1 < argc) {
+            label = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    // Results go to the file or to the original stdout; the pipeline's own logging is silenced
+    ofstream resultFile;
+    if (!outputFile.empty()) {
+        resultFile.open(outputFile);
+        if (!resultFile) {
+            cerr << "Cannot open " << outputFile << endl;
+            return 1;
+        }
+    }
+    ostream results(outputFile.empty() ? cout.rdbuf() : resultFile.rdbuf());
+    ofstream discard;
+    streambuf* coutBuffer = cout.rdbuf(discard.rdbuf());
+
+    namespace fs = std::filesystem;
+    fs::path workDir = fs::temp_directory_path() / ("cgshop_benchmark_" + to_string(seed));
+    fs::create_directories(workDir);
+
+    for (InstanceKind kind : kinds) {
+        for (size_t size : sizes) {
+            const char* kindName = instanceKindName(kind);
+            auto start = chrono::steady_clock::now();
+            InputData generated = generateInstance(kind, size, seed);
+            ResultLine(results, label, generated, kindName, "generate").field("seconds", secondsSince(start)).end();
+
+            string instanceFile = (workDir / (generated.getInstanceUid() + ".json")).string();
+            string solutionFile = (workDir / (generated.getInstanceUid() + ".solution.json")).string();
+            if (!writeInstanceJson(instanceFile, generated)) {
+                continue;
+            }
+
+            // 1. Reading the instance
+            start = chrono::steady_clock::now();
+            InputData instance = readJsonFile(instanceFile);
+            ResultLine(results, label, instance, kindName, "read_json")
+                .field("seconds", secondsSince(start))
+                .field("bytes", fs::file_size(instanceFile))
+                .end();
+
+            // 2. CDT construction
+            CDT cdt;
+            start = chrono::steady_clock::now();
+            buildTriangulation(instance, cdt);
+            ResultLine(results, label, instance, kindName, "build")
+                .field("seconds", secondsSince(start))
+                .field("vertices", cdt.number_of_vertices())
+                .field("faces", cdt.number_of_faces())
+                .end();
+
+            // Bulk obtuse classification of the fresh mesh (its face cache is still empty)
+            {
+                FaceClassification classification;
+                start = chrono::steady_clock::now();
+                classifyFaces(cdt, &classification);
+                ResultLine(results, label, instance, kindName, "classify")
+                    .field("seconds", secondsSince(start))
+                    .field("faces", classification.faces.size())
+                    .field("obtuse", classification.obtuse)
+                    .field("filtered", classification.filtered)
+                    .field("exact", classification.exact)
+                    .end();
+            }
+
+            // 3. Edge flips, both criteria (the obtuse pass on a copy, the solver continues from the Delaunay CDT)
+            start = chrono::steady_clock::now();
+            int flips = performEdgeFlips(cdt);
+            ResultLine(results, label, instance, kindName, "edge_flips")
+                .field("seconds", secondsSince(start))
+                .field("flips", flips)
+                .end();
+            {
+                CDT copy(cdt);
+                start = chrono::steady_clock::now();
+                FlipReport report;
+                performEdgeFlips(copy, shouldFlipObtuse, &report);
+                ResultLine(results, label, instance, kindName, "edge_flips_obtuse")
+                    .field("seconds", secondsSince(start))
+                    .field("flips", report.flips)
+                    .field("obtuse_delta", report.obtuse_delta)
+                    .end();
+            }
+
+            // 4. Each Steiner strategy: construction and local scoring over the first obtuse faces
+            vector<CDT::Face_handle> obtuseFaces;
+            for (auto face = cdt.finite_faces_begin(); face != cdt.finite_faces_end() && obtuseFaces.size() < strategyFaces; ++face) {
+                if (obtuseFace(face, cdt)) {
+                    obtuseFaces.push_back(face);
+                }
+            }
+            for (size_t strategy = 0; strategy < SteinerStrategies::size; ++strategy) {
+                size_t candidates = 0, improving = 0;
+                start = chrono::steady_clock::now();
+                for (const auto& face : obtuseFaces) {
+                    SteinerCandidate<Point> steiner;
+                    if (SteinerStrategies::compute<ExactConstructions>(strategy, face, cdt, steiner)) {
+                        ++candidates;
+                        if (steinerObtuseDelta(cdt, steiner.point, face) < 0) {
+                            ++improving;
+                        }
+                    }
+                }
+                ResultLine(results, label, instance, kindName, "strategy")
+                    .text("strategy", SteinerStrategies::name(strategy))
+                    .field("seconds", secondsSince(start))
+                    .field("faces", obtuseFaces.size())
+                    .field("candidates", candidates)
+                    .field("improving", improving)
+                    .end();
+            }
+
+            // 5. The full improvement loop
+            TriangulationData data;
+            string status;
+            int obtuseBefore = countObtuseAngles(cdt);
+            start = chrono::steady_clock::now();
+            int obtuseAfter = improveTriangulation(cdt, data, options, &status);
+            ResultLine(results, label, instance, kindName, "improve")
+                .field("seconds", secondsSince(start))
+                .field("threads", options.threads)
+                .field("snap_bits", options.snap_bits)
+                .field("adaptive", options.adaptive_strategies ? "true" : "false")
+                .field("strategy_skip", options.strategy_skip)
+                .field("prescreen", options.prescreen ? "true" : "false")
+                .field("obtuse_before", obtuseBefore)
+                .field("obtuse_after", obtuseAfter)
+                .field("steiner_points", data.steiner_points.size())
+                .text("status", status)
+                .end();
+
+            // 6. Writing the solution
+            start = chrono::steady_clock::now();
+            writeJsonOutput(solutionFile, instance.getInstanceUid(), data.steiner_points, cdt);
+            ResultLine(results, label, instance, kindName, "write_json")
+                .field("seconds", secondsSince(start))
+                .field("bytes", fs::exists(solutionFile) ? fs::file_size(solutionFile) : 0)
+                .end();
+
+            fs::remove(instanceFile);
+            fs::remove(solutionFile);
+        }
+    }
+
+    cout.rdbuf(coutBuffer);
+    fs::remove(workDir);
+    return 0;
+}
@@ -1,5 +1,9 @@
 #include "utils.hpp"
 #include "graphics.hpp"
+#include "render.hpp"
+#include "solver.hpp"
+#include "metrics.hpp"
+#include "snapshot.hpp"
 
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
 #include "custom.hpp"
@@ -9,165 +13,237 @@
 #include <stack>
 #include <set>
 
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 using namespace std;
 
-typedef CGAL::Exact_predicates_exact_constructions_kernel K;
-typedef CGAL::Exact_predicates_tag Itag;
-typedef Custom_Constrained_Delaunay_triangulation_2<K, CGAL::Default, Itag> CDT;
-typedef CDT::Point Point;
-typedef CGAL::Polygon_2<K> Polygon_2;
+// The kernel K and the CDT type are defined once, in utils.hpp
 
-int main() {
-    // Load the instance data from JSON file
-    string filename = "instance_data.json";
-    InputData instance_data = readJsonFile(filename);
-
-//  // Display the loaded data
-    //instance_data.display();
-
-    // Initialize Constrained Delaunay Triangulation
-    CDT cdt;
-
-    //////////////////// Insert Instance ////////////////////
-    // Insert points
-    for (size_t i = 0; i < instance_data.getPointsX().size(); ++i) {
-        cdt.insert(Point(instance_data.getPointsX()[i], instance_data.getPointsY()[i]));
+// Inputs of a batch: every *.json in a directory, or one path per line of a list file
+static vector<string> batchInputs(const string& source) {
+    namespace fs = std::filesystem;
+    vector<string> inputs;
+    if (fs::is_directory(source)) {
+        for (const auto& entry : fs::directory_iterator(source)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                inputs.push_back(entry.path().string());
+            }
+        }
+        sort(inputs.begin(), inputs.end());
+    } else {
+        ifstream list(source);
+        string line;
+        while (getline(list, line)) {
+            if (!line.empty()) {
+                inputs.push_back(line);
+            }
+        }
     }
-
-    // Insert constraints from region boundary
-    const auto& region_boundary = instance_data.getRegionBoundary();
-    for (size_t i = 0; i < region_boundary.size(); ++i) {
-        int idx1 = region_boundary[i];
-        int idx2 = region_boundary[(i + 1) % region_boundary.size()];
-        cdt.insert_constraint(Point(instance_data.getPointsX()[idx1], instance_data.getPointsY()[idx1]),
-                              Point(instance_data.getPointsX()[idx2], instance_data.getPointsY()[idx2]));
+    return inputs;
+}
+
+// SIGINT/SIGTERM: finish with the best solution so far instead of dying without output
+static void stopOnSignal(int) {
+    requestStop();
+}
+
+int main(int argc, char* argv[]) {
+    // Usage: ex [instance.json] [--threads N] [--kernel epeck|epick] [--flips delaunay|obtuse] [--binary-output <file>]
+    //        [--anneal STEPS] [--anneal-temp T0:T1] [--steiner-weight W] [--seed N] [--snap-bits B] [--tiles K]
+    //        [--adaptive] [--strategy-skip P] [--no-prescreen]
+    //        [--render <file.svg|file.png>] [--view] [--save-snapshot <file>] [--resume <snapshot>]
+    //        ex --batch <dir|list> --out <dir> [--jobs N]
+    // Both: [--time-limit S] (wall-clock budget per instance) [--checkpoint S] [--memory-limit MB] [--rss-limit MB]
+    auto runStart = chrono::steady_clock::now();
+    signal(SIGINT, stopOnSignal);
+    signal(SIGTERM, stopOnSignal);
+    string filename = "instance_data.json";
+    string batchSource;
+    string outputDir = "solutions";
+    string binaryOutput;
+    string renderFile;
+    string snapshotFile;
+    string resumeFile;
+    bool view = false;
+    unsigned jobs = max(1u, thread::hardware_concurrency());
+    bool threadsGiven = false;
+    SolverOptions options;
+    options.threads = max(1u, thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = max(1, atoi(argv[++i]));
+            threadsGiven = true;
+        } else if (arg == "--kernel" && i + 1 < argc) {
+            // epick: search with double constructions, commit exact reconstructions
+            options.inexact_constructions = (string(argv[++i]) == "epick");
+        } else if (arg == "--no-prescreen") {
+            // Every candidate straight to exact evaluation
+            options.prescreen = false;
+        } else if (arg == "--render" && i + 1 < argc) {
+            renderFile = argv[++i];
+        } else if (arg == "--view") {
+            // The blocking Qt viewer, only on request
+            view = true;
+        } else if (arg == "--save-snapshot" && i + 1 < argc) {
+            snapshotFile = argv[++i];
+        } else if (arg == "--resume" && i + 1 < argc) {
+            // Continue from a snapshot instead of reading and triangulating the instance
+            resumeFile = argv[++i];
+        } else if (arg == "--adaptive") {
+            // Most successful strategy first, stop at the first improving candidate
+            options.adaptive_strategies = true;
+        } else if (arg == "--strategy-skip" && i + 1 < argc) {
+            options.strategy_skip = atof(argv[++i]);
+        } else if (arg == "--tiles" && i + 1 < argc) {
+            options.tiles = static_cast<unsigned>(max(0, atoi(argv[++i])));
+        } else if (arg == "--snap-bits" && i + 1 < argc) {
+            options.snap_bits = max(0, atoi(argv[++i]));
+        } else if (arg == "--flips" && i + 1 < argc) {
+            options.obtuse_flips = (string(argv[++i]) == "obtuse");
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchSource = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = max(1, atoi(argv[++i]));
+        } else if (arg == "--time-limit" && i + 1 < argc) {
+            options.time_limit = atof(argv[++i]);
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            options.checkpoint_interval = atof(argv[++i]);
+        } else if (arg == "--memory-limit" && i + 1 < argc) {
+            options.memory_limit_mb = static_cast<size_t>(atol(argv[++i]));
+        } else if (arg == "--rss-limit" && i + 1 < argc) {
+            options.rss_limit_mb = static_cast<size_t>(atol(argv[++i]));
+        } else if (arg == "--binary-output" && i + 1 < argc) {
+            binaryOutput = argv[++i];
+        } else if (arg == "--anneal" && i + 1 < argc) {
+            options.anneal_steps = static_cast<size_t>(atof(argv[++i]));
+        } else if (arg == "--anneal-temp" && i + 1 < argc) {
+            // T0:T1, initial and final temperature of the geometric schedule
+            string temps = argv[++i];
+            size_t colon = temps.find(':');
+            options.anneal_t0 = atof(temps.substr(0, colon).c_str());
+            if (colon != string::npos) {
+                options.anneal_t1 = atof(temps.substr(colon + 1).c_str());
+            }
+        } else if (arg == "--steiner-weight" && i + 1 < argc) {
+            options.steiner_weight = atof(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            filename = arg;
+        }
     }
 
-    // Insert additional constraints
-    for (const auto& constraint : instance_data.getAdditionalConstraints()) {
-        if (constraint.size() == 2) {
-            cdt.insert_constraint(Point(instance_data.getPointsX()[constraint[0]], instance_data.getPointsY()[constraint[0]]),
-                                  Point(instance_data.getPointsX()[constraint[1]], instance_data.getPointsY()[constraint[1]]));
+    //////////////////// Batch Mode ////////////////////
+    if (!batchSource.empty()) {
+        vector<string> inputs = batchInputs(batchSource);
+        if (inputs.empty()) {
+            cerr << "No instances found in " << batchSource << endl;
+            return 1;
         }
+        // Instances already use every worker; evaluation stays single-threaded unless asked otherwise
+        if (!threadsGiven) {
+            options.threads = 1;
+        }
+        return runBatch(inputs, outputDir, options, jobs) == 0 ? 0 : 1;
     }
 
-    //check how many obtuse angles are in the initial polygon
-    int initialObtuseCount = countObtuseAngles(cdt);
-    cout << "Initial number of obtuse angles: " << initialObtuseCount << endl;
-
-    //////////////////// Improve CDT using Edge Flips ////////////////////
-    performEdgeFlips(cdt);
+    // Counters and phase timers of this run, written next to the solution
+    Metrics metrics;
+    METRIC_SCOPE(&metrics);
 
-    cout << "Number of obtuse angles after Edge Flips: " << countObtuseAngles(cdt) << endl;
-    
-    // I make CDT the temporary cdt and final CDT will be the optimal cdt after the steiner functions
-    CDT finalCDT = cdt;
+    // Initialize Constrained Delaunay Triangulation
+    CDT finalCDT;
     TriangulationData data;
-    
-    bool improvement = true;
-    int bestObtuseCount = countObtuseAngles(finalCDT);
-    string bestFunction;
-
-    // Συνεχής βελτίωση μέχρι να μην είναι δυνατή περαιτέρω βελτίωση
-    while (improvement) {
-        improvement = false;
-
-        // Διέλευση από όλα τα πεπερασμένα πρόσωπα για αναζήτηση αμβλέων γωνιών
-        for (auto face_iter = finalCDT.finite_faces_begin(); face_iter != finalCDT.finite_faces_end(); ++face_iter) {
-            CDT::Face_handle face = face_iter;
-
-            if (!obtuseFace(face, finalCDT)) {
-                continue;
-            }
 
-            // Μεταβλητές για την παρακολούθηση της καλύτερης βελτίωσης
-            int currentBestObtuseCount = bestObtuseCount;
-            Point bestPoint;
-            bool pointAdded = false;
-            string bestFunction;
-
-            // Δοκιμή Steiner σημείου στο circumcenter/centroid
-            CDT tempCDT = finalCDT;
-            TriangulationData tempData;
-            steinerCircumcenterCentroid(face, tempCDT, tempData);
-            int obtuseCircumcenterCount = countObtuseAngles(tempCDT);
-            if (obtuseCircumcenterCount < currentBestObtuseCount) {
-                currentBestObtuseCount = obtuseCircumcenterCount;
-                bestPoint = *tempData.steiner_points.rbegin();
-                pointAdded = true;
-                bestFunction = "Circumcenter/Centroid";
-            }
-
-            // Δοκιμή Steiner σημείου στο median
-            tempCDT = finalCDT;
-            tempData.steiner_points.clear();
-            steinerMedian(face, tempCDT, tempData);
-            int obtuseMedianCount = countObtuseAngles(tempCDT);
-            if (obtuseMedianCount < currentBestObtuseCount) {
-                currentBestObtuseCount = obtuseMedianCount;
-                bestPoint = *tempData.steiner_points.rbegin();
-                pointAdded = true;
-                bestFunction = "Median";
-            }
-
-            // Δοκιμή Steiner σημείου στην projection
-            tempCDT = finalCDT;
-            tempData.steiner_points.clear();
-            steinerProjection(face, tempCDT, tempData);
-            int obtuseProjectionCount = countObtuseAngles(tempCDT);
-            if (obtuseProjectionCount < currentBestObtuseCount) {
-                currentBestObtuseCount = obtuseProjectionCount;
-                bestPoint = *tempData.steiner_points.rbegin();
-                pointAdded = true;
-                bestFunction = "Projection";
-            }
-
-            // Δοκιμή Steiner σημείου στο κέντρο βάρους (centroid) του πολυγώνου γειτονικών τριγώνων
-            tempCDT = finalCDT;
-            tempData.steiner_points.clear();
-            centroidPolygon(face, tempCDT, tempData);
-            int obtuseCentroidCount = countObtuseAngles(tempCDT);
-            if (obtuseCentroidCount < currentBestObtuseCount) {
-                currentBestObtuseCount = obtuseCentroidCount;
-                bestPoint = *tempData.steiner_points.rbegin();
-                pointAdded = true;
-                bestFunction = "CentroidPolygon";
-            }
+    // Load the instance data from JSON file, or the triangulation itself from a snapshot
+    InputData instance_data;
+    SnapshotInfo resumed;
+    {
+        METRIC_PHASE(PHASE_READ);
+        if (resumeFile.empty()) {
+            instance_data = readJsonFile(filename);
+        } else if (!readSnapshot(resumeFile, finalCDT, resumed)) {
+            return 1;
+        }
+    }
+    const string instanceUid = resumeFile.empty() ? instance_data.getInstanceUid() : resumed.instance_uid;
+    const size_t inputPoints = resumeFile.empty() ? instance_data.getPointsX().size() : resumed.input_points;
 
-            // Αν βρέθηκε σημείο που βελτιώνει τον τριγωνισμό, το εισάγουμε
-            if (pointAdded && currentBestObtuseCount < bestObtuseCount) {
-                finalCDT.insert(bestPoint);
-                data.steiner_points.push_back(bestPoint);
-                bestObtuseCount = currentBestObtuseCount;
-                improvement = true;
-                cout << "Improvement with " << bestFunction << ", new obtuse angle count: " << bestObtuseCount << endl;
+//  // Display the loaded data
+    //instance_data.display();
 
-                // Βγαίνουμε από την επανάληψη `for` για να επανελέγξουμε όλες τις συναρτήσεις στη νέα δομή
-                //break;
-            }
+    // Snapshot of a triangulation with the progress so far (earlier runs included, when resumed)
+    auto saveSnapshot = [&](const CDT& cdt, const string& status) {
+        SnapshotInfo info;
+        info.instance_uid = instanceUid;
+        info.input_points = static_cast<uint32_t>(inputPoints);
+        info.status = status;
+        info.seconds = resumed.seconds + chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+        info.obtuse = countObtuseAngles(cdt);
+        if (writeSnapshot(snapshotFile, cdt, info)) {
+            cout << "Snapshot written to " << snapshotFile << endl;
         }
+    };
 
-        // Αν η βελτίωση παραμένει false μετά από έλεγχο όλων των προσώπων, η επανάληψη σταματά
-        if (!improvement) {
-            cout << "No further improvement is possible." << endl;
-            break;
-        }
+    // Construction, edge flips and Steiner point insertion, within what is left of the budget.
+    // Checkpoints replace the solution file atomically, so a killed run still leaves the best one so far.
+    string output_filename = "solution_output.json";
+    SolverOptions solveOptions = options;
+    if (solveOptions.time_limit > 0) {
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+        solveOptions.time_limit = max(1e-3, solveOptions.time_limit - elapsed);
     }
+    solveOptions.checkpoint = [&](const CDT& best, const TriangulationData& bestData) {
+        writeJsonOutput(output_filename, instanceUid, bestData.steiner_points, best);
+        if (!snapshotFile.empty()) {
+            saveSnapshot(best, "checkpoint");
+        }
+    };
+    SolveResult result = resumeFile.empty()
+        ? solveInstance(instance_data, solveOptions, finalCDT, data)
+        : resumeInstance(instanceUid, static_cast<int>(inputPoints), solveOptions, finalCDT, data);
 
     // Display the final count of obtuse angles after optimization
     int finalObtuseCount = countObtuseAngles(finalCDT);
     cout << "Final number of obtuse angles after Steiner point insertion: " << finalObtuseCount << endl;
 
     // Output the data to a JSON file
-    string output_filename = "solution_output.json";
     // Ορισμός της λίστας των Steiner points από τη διαδικασία βελτίωσης
     vector<Point> steiner_points = data.steiner_points;
-    writeJsonOutput(output_filename, instance_data.getInstanceUid(), steiner_points, finalCDT);
+    {
+        METRIC_PHASE(PHASE_WRITE);
+        writeJsonOutput(output_filename, instanceUid, steiner_points, finalCDT);
+        if (!binaryOutput.empty()) {
+            writeBinaryOutput(binaryOutput, instanceUid, steiner_points, finalCDT);
+        }
+        if (!snapshotFile.empty()) {
+            saveSnapshot(finalCDT, result.status);
+        }
+    }
+    if (metricsEnabled()) {
+        writeMetricsJson(metricsPathFor(output_filename), instanceUid, metrics, strategyNames());
+    }
 
-    // Draw the optimized constrained Delaunay triangulation
-    draw(finalCDT);
+    // Headless picture of the result; the interactive viewer only if asked for, and never after a stop request
+    if (!renderFile.empty()) {
+        RenderOptions renderOptions;
+        renderOptions.input_points = inputPoints;
+        if (renderTriangulation(finalCDT, renderFile, renderOptions)) {
+            cout << "Rendering written to " << renderFile << endl;
+        }
+    }
+    if (view && !stopRequested()) {
+        draw(finalCDT);
+    }
     
     return 0;
 }
\ No newline at end of file
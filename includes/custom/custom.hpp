@@ -6,7 +6,27 @@
 
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
 
+#include <array>
 
+#include <atomic>
+
+#include <mutex>
+
+#include <utility>
+
+#include <vector>
+
+
+
+// Number of traversals that can stamp faces at the same time (see next_visit_stamp)
+
+const int custom_visit_lanes = 8;
+
+
+
+// The face info must provide invalidate(), called whenever the face changes, and
+
+// visit[custom_visit_lanes], one traversal stamp per lane.
 
 template <class Gt, class Tds = CGAL::Default, class Itag = CGAL::Default>
 
@@ -26,6 +46,30 @@ public:
 
     using typename Base::Locate_type;
 
+    using typename Base::Edge;
+
+    using Ctr = typename Base::Ctr;
+
+
+
+    // Everything one tentative insertion touched, enough to undo it locally
+
+    struct Insert_record {
+
+        Vertex_handle vertex;
+
+        Locate_type lt;
+
+        Vertex_handle split_a, split_b; // endpoints of the edge the point was inserted on (lt == EDGE)
+
+        bool split_constraint = false;
+
+        std::vector<std::array<Vertex_handle, 3>> destroyed_faces; // vertices of the faces the insertion replaced
+
+        std::vector<std::pair<Face_handle, Face_handle>> flips; // the two faces of every flip, in order
+
+    };
+
 
 
     // Constructors
@@ -58,6 +102,8 @@ public:
 
         Vertex_handle va = this->Base::Ctr::insert(a, start); // Directly call Ctr::insert from the base
 
+        invalidate_incident_faces(va);
+
         return va;
 
     }
@@ -70,10 +116,572 @@ public:
 
         Vertex_handle va = this->Base::Ctr::insert(a, lt, loc, li); // Directly call Ctr::insert from the base
 
+        invalidate_incident_faces(va);
+
         return va;
 
     }
 
+
+
+    // Flip that also resets the cached data of the two faces involved
+
+    void flip(Face_handle& f, int i) {
+
+        Face_handle n = f->neighbor(i);
+
+        Base::flip(f, i);
+
+        f->info().invalidate();
+
+        n->info().invalidate();
+
+    }
+
+
+
+    // CDT::remove, resetting the cached data of the faces that fill the hole.
+
+    // As in the base class, v must not be incident to a constrained edge.
+
+    void remove(Vertex_handle v) {
+
+        std::vector<Vertex_handle> star;
+
+        if (this->dimension() == 2) {
+
+            auto vc = this->incident_vertices(v), done(vc);
+
+            do {
+
+                star.push_back(vc);
+
+            } while (++vc != done);
+
+        }
+
+        Base::remove(v);
+
+        for (Vertex_handle w : star) {
+
+            invalidate_incident_faces(w);
+
+        }
+
+    }
+
+
+
+    // Changes made through this class reset the face caches locally; call this after
+
+    // modifying the triangulation through the base class (insert, insert_constraint, ...)
+
+    void invalidate_face_cache() {
+
+        for (auto f = this->all_faces_begin(); f != this->all_faces_end(); ++f) {
+
+            f->info().invalidate();
+
+        }
+
+    }
+
+
+
+    // Claims a free lane of this triangulation for a traversal; false if all are taken.
+
+    // Lanes are per triangulation, so traversals of different triangulations never compete.
+
+    bool acquire_visit_lane(int& lane) const {
+
+        unsigned busy = visit_lanes_.busy.load(std::memory_order_relaxed);
+
+        while (true) {
+
+            lane = 0;
+
+            while (lane < custom_visit_lanes && (busy & (1u << lane))) {
+
+                ++lane;
+
+            }
+
+            if (lane == custom_visit_lanes) {
+
+                return false;
+
+            }
+
+            if (visit_lanes_.busy.compare_exchange_weak(busy, busy | (1u << lane), std::memory_order_acquire, std::memory_order_relaxed)) {
+
+                return true;
+
+            }
+
+        }
+
+    }
+
+
+
+    void release_visit_lane(int lane) const {
+
+        visit_lanes_.busy.fetch_and(~(1u << lane), std::memory_order_release);
+
+    }
+
+
+
+    // Fresh stamp for a traversal holding `lane`. Only the holder of a lane reads or writes
+
+    // its stamps, so traversals in different lanes can run concurrently on a const triangulation.
+
+    unsigned short next_visit_stamp(int lane) const {
+
+        if (++visit_epochs_[lane] == 0) {
+
+            // Wrapped around: old stamps could collide with new ones
+
+            for (auto f = this->all_faces_begin(); f != this->all_faces_end(); ++f) {
+
+                f->info().visit[lane] = 0;
+
+            }
+
+            visit_epochs_[lane] = 1;
+
+        }
+
+        return visit_epochs_[lane];
+
+    }
+
+
+
+    // Base::locate walks with this triangulation's own random generator: concurrent walks on
+
+    // one triangulation must hold this lock, walks on different triangulations need not.
+
+    std::mutex& locate_mutex() const {
+
+        return locate_lock_.mutex;
+
+    }
+
+
+
+    // Transactions: checkpoint(), then any number of tentative_insert(), then commit() or rollback().
+
+    // Each insertion is logged (split type, replaced faces, flips), so rollback costs only the local change.
+
+    void checkpoint() {
+
+        undo_log_.clear();
+
+    }
+
+
+
+    Vertex_handle tentative_insert(const Point& a, Face_handle start = Face_handle()) {
+
+        Locate_type lt;
+
+        int li;
+
+        Face_handle loc = this->locate(a, lt, li, start);
+
+        return tentative_insert(a, lt, loc, li);
+
+    }
+
+
+
+    // Same result as CDT::insert (split, then Lawson flips around the new vertex), but logged
+
+    Vertex_handle tentative_insert(const Point& a, Locate_type lt, Face_handle loc, int li) {
+
+        Insert_record record;
+
+        record.lt = lt;
+
+        if (lt == Base::FACE || lt == Base::EDGE) {
+
+            record.destroyed_faces.push_back(face_vertices(loc));
+
+        }
+
+        if (lt == Base::EDGE) {
+
+            record.split_a = loc->vertex(this->cw(li));
+
+            record.split_b = loc->vertex(this->ccw(li));
+
+            record.split_constraint = loc->is_constrained(li);
+
+            record.destroyed_faces.push_back(face_vertices(loc->neighbor(li)));
+
+        }
+
+
+
+        record.vertex = this->Base::Ctr::insert(a, lt, loc, li);
+
+        if (lt != Base::VERTEX) {
+
+            flip_around_logged(record);
+
+            // Every face the insertion created or reshaped is incident to the new vertex
+
+            invalidate_incident_faces(record.vertex);
+
+        }
+
+        undo_log_.push_back(record);
+
+        return record.vertex;
+
+    }
+
+
+
+    const Insert_record& last_insert() const {
+
+        return undo_log_.back();
+
+    }
+
+
+
+    void commit() {
+
+        undo_log_.clear();
+
+    }
+
+
+
+    // Undo every tentative insertion since the last checkpoint, newest first
+
+    void rollback() {
+
+        while (!undo_log_.empty()) {
+
+            undo_insert(undo_log_.back());
+
+            undo_log_.pop_back();
+
+        }
+
+    }
+
+
+
+    // Rebuilds the triangulation from its combinatorics alone, e.g. from a saved snapshot:
+
+    // no point location, no flips, no predicates. faces[k] holds indices into `points`
+
+    // (-1 for the infinite vertex), neighbors[k][i] the face opposite vertex i of face k,
+
+    // and bit i of constrained[k] whether that edge is constrained. The arrays must describe
+
+    // a valid 2D triangulation of the points; handles[i] receives the vertex of points[i].
+
+    void rebuild(const std::vector<Point>& points,
+
+                 const std::vector<std::array<int, 3>>& faces,
+
+                 const std::vector<std::array<int, 3>>& neighbors,
+
+                 const std::vector<unsigned char>& constrained,
+
+                 std::vector<Vertex_handle>& handles) {
+
+        undo_log_.clear();
+
+        this->tds().clear();
+
+        Vertex_handle infinite = this->tds().create_vertex();
+
+        this->set_infinite_vertex(infinite);
+
+        handles.resize(points.size());
+
+        for (std::size_t i = 0; i < points.size(); ++i) {
+
+            handles[i] = this->tds().create_vertex();
+
+            handles[i]->set_point(points[i]);
+
+        }
+
+        std::vector<Face_handle> created(faces.size());
+
+        for (std::size_t k = 0; k < faces.size(); ++k) {
+
+            Vertex_handle v[3];
+
+            for (int i = 0; i < 3; ++i) {
+
+                v[i] = faces[k][i] < 0 ? infinite : handles[faces[k][i]];
+
+            }
+
+            created[k] = this->tds().create_face(v[0], v[1], v[2]);
+
+        }
+
+        for (std::size_t k = 0; k < faces.size(); ++k) {
+
+            for (int i = 0; i < 3; ++i) {
+
+                created[k]->set_neighbor(i, created[neighbors[k][i]]);
+
+                created[k]->set_constraint(i, ((constrained[k] >> i) & 1) != 0);
+
+                created[k]->vertex(i)->set_face(created[k]);
+
+            }
+
+        }
+
+        this->tds().set_dimension(2);
+
+    }
+
+
+
+private:
+
+    // A copy gets a fresh, unlocked mutex of its own
+
+    struct Locate_lock {
+
+        std::mutex mutex;
+
+        Locate_lock() = default;
+
+        Locate_lock(const Locate_lock&) {}
+
+        Locate_lock& operator=(const Locate_lock&) { return *this; }
+
+    };
+
+
+
+    // Bit i set while lane i is held by a traversal; a copy starts with every lane free
+
+    struct Visit_lanes {
+
+        std::atomic<unsigned> busy{0};
+
+        Visit_lanes() = default;
+
+        Visit_lanes(const Visit_lanes&) {}
+
+        Visit_lanes& operator=(const Visit_lanes&) { return *this; }
+
+    };
+
+
+
+    std::vector<Insert_record> undo_log_;
+
+    mutable std::array<unsigned short, custom_visit_lanes> visit_epochs_{};
+
+    mutable Locate_lock locate_lock_;
+
+    mutable Visit_lanes visit_lanes_;
+
+
+
+    void invalidate_incident_faces(Vertex_handle v) {
+
+        if (this->dimension() < 2) {
+
+            return;
+
+        }
+
+        auto fc = this->incident_faces(v), done(fc);
+
+        do {
+
+            fc->info().invalidate();
+
+        } while (++fc != done);
+
+    }
+
+
+
+    static std::array<Vertex_handle, 3> face_vertices(Face_handle f) {
+
+        return {{f->vertex(0), f->vertex(1), f->vertex(2)}};
+
+    }
+
+
+
+    // CDT::flip_around, recording every flip and the old face it consumes
+
+    void flip_around_logged(Insert_record& record) {
+
+        if (this->dimension() <= 1) {
+
+            return;
+
+        }
+
+        Vertex_handle va = record.vertex;
+
+        Face_handle f = va->face();
+
+        Face_handle next;
+
+        Face_handle start(f);
+
+        do {
+
+            int i = f->index(va);
+
+            next = f->neighbor(this->ccw(i)); // turns ccw around va
+
+            propagating_flip_logged(f, i, record);
+
+            f = next;
+
+        } while (next != start);
+
+    }
+
+
+
+    void propagating_flip_logged(Face_handle f, int i, Insert_record& record) {
+
+        if (!this->is_flipable(f, i)) {
+
+            return;
+
+        }
+
+        Face_handle ni = f->neighbor(i);
+
+        record.destroyed_faces.push_back(face_vertices(ni));
+
+        record.flips.push_back(std::make_pair(f, ni));
+
+        Base::flip(f, i); // keeps f and ni, with f->vertex(i) unchanged
+
+        propagating_flip_logged(f, i, record);
+
+        i = ni->index(f->vertex(i));
+
+        propagating_flip_logged(ni, i, record);
+
+    }
+
+
+
+    // Restore the constrained flags of f from its neighbours; `inner` shares an edge with f whose flag is `inner_flag`
+
+    void restore_constraints(Face_handle f, Face_handle inner = Face_handle(), bool inner_flag = false) {
+
+        for (int i = 0; i < 3; ++i) {
+
+            Face_handle n = f->neighbor(i);
+
+            f->set_constraint(i, n == inner ? inner_flag : n->is_constrained(n->index(f)));
+
+        }
+
+    }
+
+
+
+    void undo_insert(const Insert_record& record) {
+
+        if (record.lt == Base::VERTEX) {
+
+            return; // the point was already a vertex, nothing was inserted
+
+        }
+
+
+
+        // Flipping the diagonal of (f, g) again restores the edge the flip removed
+
+        for (auto it = record.flips.rbegin(); it != record.flips.rend(); ++it) {
+
+            Face_handle f = it->first;
+
+            Base::flip(f, f->index(it->second));
+
+            f->info().invalidate();
+
+            it->second->info().invalidate();
+
+        }
+
+
+
+        Vertex_handle v = record.vertex;
+
+        if (record.lt == Base::FACE) {
+
+            // v is back to the star of the split face
+
+            Face_handle f = v->face();
+
+            this->tds().remove_degree_3(v, f);
+
+            restore_constraints(f);
+
+            f->info().invalidate();
+
+        } else if (record.lt == Base::EDGE) {
+
+            // v splits the edge (a, b) into a star of four faces: flip one edge from v to an apex
+
+            // (purely combinatorial, the new face is flat), which leaves v with degree 3
+
+            Face_handle f = v->face();
+
+            int i = f->index(v);
+
+            while (f->vertex(this->ccw(i)) == record.split_a || f->vertex(this->ccw(i)) == record.split_b) {
+
+                f = f->neighbor(this->cw(i));
+
+                i = f->index(v);
+
+            }
+
+            Face_handle apex_face = f->neighbor(this->cw(i));
+
+            this->tds().flip(f, this->cw(i));
+
+            Face_handle kept = v->face();
+
+            this->tds().remove_degree_3(v, kept);
+
+            restore_constraints(kept, apex_face, record.split_constraint);
+
+            restore_constraints(apex_face, kept, record.split_constraint);
+
+            kept->info().invalidate();
+
+            apex_face->info().invalidate();
+
+        } else {
+
+            // Outside the convex hull: no constraint is incident to v, let the CDT retriangulate its star
+
+            remove(v);
+
+        }
+
+    }
+
 };
 
 
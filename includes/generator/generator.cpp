@@ -0,0 +1,333 @@
+#include "generator.hpp"
+#include "output_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+
+using namespace std;
+
+namespace {
+
+// Uniform integer in [lo, hi]; modulo bias is irrelevant for benchmark inputs
+int64_t uniformInt(mt19937_64& rng, int64_t lo, int64_t hi) {
+    return lo + static_cast<int64_t>(rng() % static_cast<uint64_t>(hi - lo + 1));
+}
+
+// Uniform double in [0, 1)
+double uniformReal(mt19937_64& rng) {
+    return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int64_t orient(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t px, int64_t py) {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// Largest r with r * r <= n
+uint64_t isqrt(unsigned __int128 n) {
+    uint64_t lo = 0, hi = 1ull << 63;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (static_cast<unsigned __int128>(mid) * mid <= n) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Exact angular order of directions around the origin, starting from the positive x axis.
+// No libm: sin, cos and atan2 are not correctly rounded and differ between platforms.
+bool angleLess(int64_t ax, int64_t ay, int64_t bx, int64_t by) {
+    bool lowerA = ay < 0 || (ay == 0 && ax < 0);
+    bool lowerB = by < 0 || (by == 0 && bx < 0);
+    if (lowerA != lowerB) {
+        return lowerB;
+    }
+    return ax * by - ay * bx > 0;
+}
+
+// Direction at `turn` in [0, 1) of a counter-clockwise walk around the square [-s, s]^2,
+// starting at (s, 0): monotone in angle, like a point on the circle
+void squareDirection(double turn, int64_t s, int64_t& dx, int64_t& dy) {
+    int64_t pos = static_cast<int64_t>(turn * 8 * s);
+    if (pos < s) {
+        dx = s; dy = pos;
+    } else if (pos < 3 * s) {
+        dx = 2 * s - pos; dy = s;
+    } else if (pos < 5 * s) {
+        dx = -s; dy = 4 * s - pos;
+    } else if (pos < 7 * s) {
+        dx = pos - 6 * s; dy = -s;
+    } else {
+        dx = s; dy = pos - 8 * s;
+    }
+}
+
+// Point set without duplicates
+struct PointSet {
+    vector<int> xs, ys;
+    unordered_set<uint64_t> used;
+
+    bool add(int64_t x, int64_t y) {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        if (!used.insert(key).second) {
+            return false;
+        }
+        xs.push_back(static_cast<int>(x));
+        ys.push_back(static_cast<int>(y));
+        return true;
+    }
+    size_t size() const { return xs.size(); }
+};
+
+// Boundary star-shaped around (cx, cy): vertices in increasing angle, so a point is inside
+// iff it lies strictly left of the edge of the wedge that contains it
+struct StarBoundary {
+    int64_t cx, cy;
+    vector<int64_t> xs, ys;
+
+    bool inWedge(size_t i, int64_t px, int64_t py) const {
+        size_t j = (i + 1) % xs.size();
+        return orient(cx, cy, xs[i], ys[i], px, py) >= 0 && orient(cx, cy, xs[j], ys[j], px, py) <= 0;
+    }
+
+    bool contains(int64_t px, int64_t py) const {
+        if (px == cx && py == cy) {
+            return true;
+        }
+        // First vertex past the point's direction, in exact angular order
+        size_t lo = 0, hi = xs.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (angleLess(px - cx, py - cy, xs[mid] - cx, ys[mid] - cy)) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        size_t m = xs.size();
+        size_t i = (lo + m - 1) % m;
+        // On a ray the neighbouring wedge holds the point as well: settle it with exact orientations
+        for (size_t candidate : {i, (i + m - 1) % m, (i + 1) % m}) {
+            if (inWedge(candidate, px, py)) {
+                size_t j = (candidate + 1) % m;
+                return orient(xs[candidate], ys[candidate], xs[j], ys[j], px, py) > 0;
+            }
+        }
+        return false;
+    }
+};
+
+// m vertices at stratified random angles; convex ones on a circle, others at random radii.
+// Integer arithmetic only (the radius is rounded once), so the boundary is the same everywhere.
+StarBoundary starBoundary(mt19937_64& rng, int64_t center, int64_t radius, size_t m, bool convex) {
+    const int64_t s = 1 << 20; // resolution of the directions
+    StarBoundary boundary;
+    boundary.cx = center;
+    boundary.cy = center;
+    for (size_t k = 0; k < m; ++k) {
+        int64_t dx, dy;
+        squareDirection((k + 0.1 + 0.8 * uniformReal(rng)) / m, s, dx, dy);
+        int64_t r = llround(radius * (convex ? 1.0 : 0.4 + 0.6 * uniformReal(rng)));
+        // (r dx, r dy) / |(dx, dy)|, each component rounded down in magnitude
+        unsigned __int128 length2 = static_cast<unsigned __int128>(dx * dx + dy * dy);
+        unsigned __int128 r2 = static_cast<unsigned __int128>(r) * r;
+        int64_t ox = static_cast<int64_t>(isqrt(r2 * static_cast<uint64_t>(dx * dx) / length2));
+        int64_t oy = static_cast<int64_t>(isqrt(r2 * static_cast<uint64_t>(dy * dy) / length2));
+        int64_t x = center + (dx < 0 ? -ox : ox);
+        int64_t y = center + (dy < 0 ? -oy : oy);
+        if (!boundary.xs.empty() && x == boundary.xs.back() && y == boundary.ys.back()) {
+            continue;
+        }
+        boundary.xs.push_back(x);
+        boundary.ys.push_back(y);
+    }
+    return boundary;
+}
+
+// Rectangle [0, side]^2 with lattice points every `step` along its sides, counter-clockwise
+void rectangleBoundary(PointSet& points, vector<int>& region_boundary, int64_t side, int64_t step) {
+    int64_t x = 0, y = 0;
+    const int64_t dx[4] = {1, 0, -1, 0};
+    const int64_t dy[4] = {0, 1, 0, -1};
+    for (int d = 0; d < 4; ++d) {
+        for (int64_t t = 0; t < side; t += step) {
+            region_boundary.push_back(static_cast<int>(points.size()));
+            points.add(x, y);
+            x += dx[d] * step;
+            y += dy[d] * step;
+        }
+    }
+}
+
+// Non-crossing constraints: the points of each horizontal band, joined in x order.
+// Bands are disjoint strips, and an x-monotone chain inside a strip cannot cross itself.
+vector<vector<int>> bandChains(mt19937_64& rng, const PointSet& points, size_t first, int64_t side, double density) {
+    size_t interior = points.size() - first;
+    size_t bands = max<size_t>(1, static_cast<size_t>(sqrt(static_cast<double>(interior)) / 2));
+    vector<vector<int>> members(bands);
+    for (size_t i = first; i < points.size(); ++i) {
+        size_t band = min(bands - 1, static_cast<size_t>(points.ys[i]) * bands / static_cast<size_t>(side + 1));
+        members[band].push_back(static_cast<int>(i));
+    }
+
+    vector<vector<int>> constraints;
+    for (auto& band : members) {
+        sort(band.begin(), band.end(), [&](int a, int b) {
+            return points.xs[a] != points.xs[b] ? points.xs[a] < points.xs[b] : points.ys[a] < points.ys[b];
+        });
+        for (size_t k = 1; k < band.size(); ++k) {
+            if (uniformReal(rng) < density) {
+                constraints.push_back({band[k - 1], band[k]});
+            }
+        }
+    }
+    return constraints;
+}
+
+} // namespace
+
+bool parseInstanceKind(const string& name, InstanceKind& kind) {
+    for (InstanceKind candidate : {InstanceKind::Convex, InstanceKind::NonConvex, InstanceKind::Grid,
+                                   InstanceKind::Clustered, InstanceKind::Constrained}) {
+        if (name == instanceKindName(candidate)) {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* instanceKindName(InstanceKind kind) {
+    switch (kind) {
+        case InstanceKind::Convex: return "convex";
+        case InstanceKind::NonConvex: return "nonconvex";
+        case InstanceKind::Grid: return "grid";
+        case InstanceKind::Clustered: return "clustered";
+        case InstanceKind::Constrained: return "constrained";
+    }
+    return "unknown";
+}
+
+InputData generateInstance(InstanceKind kind, size_t num_points, uint64_t seed) {
+    mt19937_64 rng(seed);
+    num_points = max<size_t>(num_points, 8);
+    // Room for every point without crowding, within int coordinates
+    int64_t side = max<int64_t>(1000, 20 * static_cast<int64_t>(num_points));
+
+    PointSet points;
+    vector<int> region_boundary;
+    vector<vector<int>> constraints;
+
+    if (kind == InstanceKind::Convex || kind == InstanceKind::NonConvex) {
+        size_t m = max<size_t>(8, static_cast<size_t>(sqrt(static_cast<double>(num_points))));
+        StarBoundary boundary = starBoundary(rng, side / 2, side / 2, m, kind == InstanceKind::Convex);
+        for (size_t k = 0; k < boundary.xs.size(); ++k) {
+            region_boundary.push_back(static_cast<int>(points.size()));
+            points.add(boundary.xs[k], boundary.ys[k]);
+        }
+        while (points.size() < num_points) {
+            int64_t x = uniformInt(rng, 0, side);
+            int64_t y = uniformInt(rng, 0, side);
+            if (boundary.contains(x, y)) {
+                points.add(x, y);
+            }
+        }
+    } else if (kind == InstanceKind::Grid) {
+        int64_t step = 10;
+        int64_t cells = max<int64_t>(2, static_cast<int64_t>(ceil(sqrt(static_cast<double>(num_points)))) + 1);
+        rectangleBoundary(points, region_boundary, cells * step, step);
+        for (int64_t i = 1; i < cells && points.size() < num_points; ++i) {
+            for (int64_t j = 1; j < cells && points.size() < num_points; ++j) {
+                points.add(i * step, j * step);
+            }
+        }
+    } else {
+        rectangleBoundary(points, region_boundary, side, side);
+        size_t first = points.size();
+        if (kind == InstanceKind::Clustered) {
+            size_t clusters = max<size_t>(1, num_points / 1000);
+            int64_t spread = max<int64_t>(10, side / (8 * static_cast<int64_t>(sqrt(static_cast<double>(clusters))) + 8));
+            vector<pair<int64_t, int64_t>> centers;
+            for (size_t c = 0; c < clusters; ++c) {
+                centers.push_back({uniformInt(rng, spread, side - spread), uniformInt(rng, spread, side - spread)});
+            }
+            while (points.size() < num_points) {
+                const auto& center = centers[rng() % clusters];
+                // Sum of three uniforms: roughly normal around the center
+                int64_t x = center.first, y = center.second;
+                for (int k = 0; k < 3; ++k) {
+                    x += uniformInt(rng, -spread, spread) / 3;
+                    y += uniformInt(rng, -spread, spread) / 3;
+                }
+                if (x > 0 && x < side && y > 0 && y < side) {
+                    points.add(x, y);
+                }
+            }
+        } else {
+            while (points.size() < num_points) {
+                points.add(uniformInt(rng, 1, side - 1), uniformInt(rng, 1, side - 1));
+            }
+            constraints = bandChains(rng, points, first, side, 0.5);
+        }
+    }
+
+    InputData instance;
+    instance.setInstanceUid(string(instanceKindName(kind)) + "_" + to_string(points.size()) + "_s" + to_string(seed));
+    instance.setNumPoints(static_cast<int>(points.size()));
+    instance.setNumConstraints(static_cast<int>(constraints.size()));
+    instance.setPointsX(move(points.xs));
+    instance.setPointsY(move(points.ys));
+    instance.setRegionBoundary(move(region_boundary));
+    instance.setAdditionalConstraints(move(constraints));
+    return instance;
+}
+
+static void writeIntArray(BufferedWriter& out, const vector<int>& values) {
+    out.put('[');
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            out.write(", ", 2);
+        }
+        out.writeInt(values[i]);
+    }
+    out.put(']');
+}
+
+bool writeInstanceJson(const string& filename, const InputData& instance) {
+    BufferedWriter out(filename);
+    if (!out.isOpen()) {
+        cerr << "Error writing instance: cannot open " << filename << endl;
+        return false;
+    }
+
+    out.write("{\n    \"instance_uid\": ");
+    out.writeJsonString(instance.getInstanceUid());
+    out.write(",\n    \"num_points\": ");
+    out.writeInt(instance.getNumPoints());
+    out.write(",\n    \"points_x\": ");
+    writeIntArray(out, instance.getPointsX());
+    out.write(",\n    \"points_y\": ");
+    writeIntArray(out, instance.getPointsY());
+    out.write(",\n    \"region_boundary\": ");
+    writeIntArray(out, instance.getRegionBoundary());
+    out.write(",\n    \"num_constraints\": ");
+    out.writeInt(instance.getNumConstraints());
+    out.write(",\n    \"additional_constraints\": [");
+    const auto& constraints = instance.getAdditionalConstraints();
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        out.write(i > 0 ? ",\n        " : "\n        ");
+        writeIntArray(out, constraints[i]);
+    }
+    out.write(constraints.empty() ? "]\n}\n" : "\n    ]\n}\n");
+
+    if (!out.close()) {
+        cerr << "Error writing instance: write to " << filename << " failed" << endl;
+        return false;
+    }
+    return true;
+}
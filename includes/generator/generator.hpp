@@ -0,0 +1,33 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include "utils.hpp"
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Synthetic instance families for benchmarks
+enum class InstanceKind {
+    Convex,      // random convex boundary, uniform interior points
+    NonConvex,   // random star-shaped boundary, uniform interior points
+    Grid,        // square lattice (many cocircular points) inside a rectangle
+    Clustered,   // dense clusters inside a rectangle
+    Constrained  // uniform points inside a rectangle, dense non-crossing constraint chains
+};
+
+bool parseInstanceKind(const string& name, InstanceKind& kind);
+const char* instanceKindName(InstanceKind kind);
+
+// Deterministic for a given (kind, num_points, seed) on every platform: only the raw
+// mt19937_64 output is used, never the implementation-defined std distributions, and
+// the geometry needs only integer and correctly rounded arithmetic (no sin/cos/atan2).
+// The first points are the region boundary, in counter-clockwise order; all other
+// points lie strictly inside it and no two points coincide.
+InputData generateInstance(InstanceKind kind, size_t num_points, uint64_t seed);
+
+// Writes the instance in the input JSON format read by readJsonFile
+bool writeInstanceJson(const string& filename, const InputData& instance);
+
+#endif // GENERATOR_HPP
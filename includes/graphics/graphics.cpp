@@ -2,7 +2,7 @@
 
 Graphics::Graphics(const InputData& instance_data) : instance_data_(instance_data) {}
 
-void Graphics::drawTriangulation() {
+void Graphics::drawTriangulation(const string& filename, bool interactive) {
     // Initialize Constrained Delaunay Triangulation
     CDT cdt;
 
@@ -28,5 +28,8 @@ void Graphics::drawTriangulation() {
     }
 
     cout << "The number of resulting constrained edges is " << count << endl;
-    CGAL::draw(cdt);
+    renderTriangulation(cdt, filename);
+    if (interactive) {
+        CGAL::draw(cdt);
+    }
 }
@@ -6,22 +6,22 @@
 #include "custom.hpp"
 #include <CGAL/draw_constrained_triangulation_2.h>
 #include "utils.hpp"
+#include "render.hpp"
 
 #include <cassert>
 #include <iostream>
 
 using namespace std;
 
-typedef CGAL::Exact_predicates_exact_constructions_kernel K;
-typedef CGAL::Exact_predicates_tag Itag;
-typedef Custom_Constrained_Delaunay_triangulation_2<K, CGAL::Default, Itag> CDT;
-typedef CDT::Point Point;
+// K, CDT and Point come from utils.hpp
 typedef CDT::Edge Edge;
 
 class Graphics {
 public:
     Graphics(const InputData& instance_data);
-    void drawTriangulation();
+    // Renders the constraint grid to `filename` (SVG or PNG); the blocking Qt viewer
+    // opens only if `interactive` is set
+    void drawTriangulation(const string& filename = "constraint_grid.svg", bool interactive = false);
 
 private:
     const InputData& instance_data_;
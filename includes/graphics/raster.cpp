@@ -0,0 +1,202 @@
+#include "raster.hpp"
+#include "output_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+Raster::Raster(int width, int height, uint32_t background)
+    : width_(max(1, width)), height_(max(1, height)), pixels_(static_cast<size_t>(width_) * height_ * 3) {
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            set(x, y, background);
+        }
+    }
+}
+
+void Raster::fillTriangle(double x0, double y0, double x1, double y1, double x2, double y2, uint32_t rgb) {
+    double area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (area == 0) {
+        return;
+    }
+    int minX = max(0, static_cast<int>(floor(min({x0, x1, x2}))));
+    int maxX = min(width_ - 1, static_cast<int>(ceil(max({x0, x1, x2}))));
+    int minY = max(0, static_cast<int>(floor(min({y0, y1, y2}))));
+    int maxY = min(height_ - 1, static_cast<int>(ceil(max({y0, y1, y2}))));
+    // Edge functions, sign-normalized so that inside is non-negative for both orientations
+    double sign = area > 0 ? 1 : -1;
+    for (int y = minY; y <= maxY; ++y) {
+        double py = y + 0.5;
+        for (int x = minX; x <= maxX; ++x) {
+            double px = x + 0.5;
+            double e0 = sign * ((x1 - x0) * (py - y0) - (y1 - y0) * (px - x0));
+            double e1 = sign * ((x2 - x1) * (py - y1) - (y2 - y1) * (px - x1));
+            double e2 = sign * ((x0 - x2) * (py - y2) - (y0 - y2) * (px - x2));
+            if (e0 >= 0 && e1 >= 0 && e2 >= 0) {
+                set(x, y, rgb);
+            }
+        }
+    }
+}
+
+void Raster::line(double x0, double y0, double x1, double y1, uint32_t rgb, int thickness) {
+    // Sampled at every pixel step along the longer axis
+    double dx = x1 - x0, dy = y1 - y0;
+    int steps = max(1, static_cast<int>(ceil(max(fabs(dx), fabs(dy)))));
+    int lo = -(thickness - 1) / 2, hi = thickness / 2;
+    bool steep = fabs(dy) > fabs(dx);
+    for (int i = 0; i <= steps; ++i) {
+        int x = static_cast<int>(floor(x0 + dx * i / steps));
+        int y = static_cast<int>(floor(y0 + dy * i / steps));
+        for (int offset = lo; offset <= hi; ++offset) {
+            if (steep) {
+                set(x + offset, y, rgb);
+            } else {
+                set(x, y + offset, rgb);
+            }
+        }
+    }
+}
+
+void Raster::dot(double x, double y, int radius, uint32_t rgb) {
+    int cx = static_cast<int>(floor(x)), cy = static_cast<int>(floor(y));
+    for (int oy = -radius; oy <= radius; ++oy) {
+        for (int ox = -radius; ox <= radius; ++ox) {
+            set(cx + ox, cy + oy, rgb);
+        }
+    }
+}
+
+namespace {
+
+uint32_t crcTable[256];
+
+void initCrcTable() {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[n] = c;
+    }
+}
+
+uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+// One PNG chunk: big-endian length, type, data, CRC over type and data.
+// The data is produced in pieces, so the CRC is accumulated as they are written.
+class PngChunk {
+public:
+    PngChunk(BufferedWriter& out, const char* type, uint32_t length) : out_(out) {
+        writeBigEndian(length);
+        out_.write(type, 4);
+        crc_ = updateCrc(0xFFFFFFFFu, reinterpret_cast<const uint8_t*>(type), 4);
+    }
+    void write(const uint8_t* data, size_t size) {
+        out_.write(reinterpret_cast<const char*>(data), size);
+        crc_ = updateCrc(crc_, data, size);
+    }
+    void writeU32(uint32_t value) {
+        uint8_t bytes[4] = {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                            static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+        write(bytes, 4);
+    }
+    void end() {
+        writeBigEndian(crc_ ^ 0xFFFFFFFFu);
+    }
+
+private:
+    void writeBigEndian(uint32_t value) {
+        char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                         static_cast<char>(value >> 8), static_cast<char>(value)};
+        out_.write(bytes, 4);
+    }
+
+    BufferedWriter& out_;
+    uint32_t crc_;
+};
+
+} // namespace
+
+bool Raster::writePng(const string& filename) const {
+    static bool crcReady = (initCrcTable(), true);
+    (void)crcReady;
+
+    BufferedWriter out(filename);
+    if (!out.isOpen()) {
+        cerr << "Error writing PNG: cannot open " << filename << endl;
+        return false;
+    }
+    out.write("\x89PNG\r\n\x1a\n", 8);
+
+    PngChunk header(out, "IHDR", 13);
+    header.writeU32(static_cast<uint32_t>(width_));
+    header.writeU32(static_cast<uint32_t>(height_));
+    const uint8_t format[5] = {8, 2, 0, 0, 0}; // 8-bit RGB, deflate, adaptive filtering, no interlace
+    header.write(format, 5);
+    header.end();
+
+    // zlib stream of stored blocks over the scanlines, each prefixed with filter type 0
+    const size_t rowBytes = static_cast<size_t>(width_) * 3 + 1;
+    const size_t rawBytes = rowBytes * height_;
+    const size_t maxBlock = 65535;
+    const size_t blocks = max<size_t>(1, (rawBytes + maxBlock - 1) / maxBlock);
+    const size_t idatLength = 2 + blocks * 5 + rawBytes + 4;
+    if (idatLength > 0x7FFFFFFFu) {
+        cerr << "Error writing PNG: image too large for one uncompressed chunk" << endl;
+        return false;
+    }
+    PngChunk data(out, "IDAT", static_cast<uint32_t>(idatLength));
+    const uint8_t zlibHeader[2] = {0x78, 0x01};
+    data.write(zlibHeader, 2);
+
+    uint32_t adlerA = 1, adlerB = 0;
+    size_t position = 0; // in the raw stream
+    size_t blockLeft = 0;
+    size_t blocksWritten = 0;
+    auto emit = [&](const uint8_t* bytes, size_t size) {
+        while (size > 0) {
+            if (blockLeft == 0) {
+                blockLeft = min(maxBlock, rawBytes - position);
+                ++blocksWritten;
+                uint8_t blockHeader[5] = {static_cast<uint8_t>(blocksWritten == blocks ? 1 : 0),
+                                          static_cast<uint8_t>(blockLeft), static_cast<uint8_t>(blockLeft >> 8),
+                                          static_cast<uint8_t>(~blockLeft), static_cast<uint8_t>(~blockLeft >> 8)};
+                data.write(blockHeader, 5);
+            }
+            size_t take = min(size, blockLeft);
+            data.write(bytes, take);
+            for (size_t i = 0; i < take; ++i) {
+                adlerA = (adlerA + bytes[i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+            bytes += take;
+            size -= take;
+            blockLeft -= take;
+            position += take;
+        }
+    };
+    const uint8_t filter = 0;
+    for (int y = 0; y < height_; ++y) {
+        emit(&filter, 1);
+        emit(&pixels_[static_cast<size_t>(y) * width_ * 3], static_cast<size_t>(width_) * 3);
+    }
+    data.writeU32((adlerB << 16) | adlerA);
+    data.end();
+
+    PngChunk trailer(out, "IEND", 0);
+    trailer.end();
+
+    if (!out.close()) {
+        cerr << "Error writing PNG: write to " << filename << " failed" << endl;
+        return false;
+    }
+    return true;
+}
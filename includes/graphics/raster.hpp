@@ -0,0 +1,45 @@
+#ifndef RASTER_HPP
+#define RASTER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// RGB image in memory for headless rendering, written as PNG without any image library:
+// the pixel data goes into stored (uncompressed) deflate blocks. Drawing is clipped to the image.
+// Colors are 0xRRGGBB; y grows downwards.
+class Raster {
+public:
+    Raster(int width, int height, uint32_t background);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    void set(int x, int y, uint32_t rgb) {
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+            return;
+        }
+        uint8_t* pixel = &pixels_[(static_cast<size_t>(y) * width_ + x) * 3];
+        pixel[0] = static_cast<uint8_t>(rgb >> 16);
+        pixel[1] = static_cast<uint8_t>(rgb >> 8);
+        pixel[2] = static_cast<uint8_t>(rgb);
+    }
+
+    // Pixels whose centers lie inside the triangle (either orientation)
+    void fillTriangle(double x0, double y0, double x1, double y1, double x2, double y2, uint32_t rgb);
+    // Line through pixel centers, `thickness` pixels wide
+    void line(double x0, double y0, double x1, double y1, uint32_t rgb, int thickness = 1);
+    // Filled square of side 2 * radius + 1 centered on (x, y)
+    void dot(double x, double y, int radius, uint32_t rgb);
+
+    bool writePng(const string& filename) const;
+
+private:
+    int width_;
+    int height_;
+    vector<uint8_t> pixels_;
+};
+
+#endif // RASTER_HPP
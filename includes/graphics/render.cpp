@@ -0,0 +1,240 @@
+#include "render.hpp"
+#include "raster.hpp"
+#include "output_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+const uint32_t backgroundColor = 0xFFFFFF;
+const uint32_t faceColor = 0xE8EEF4;
+const uint32_t obtuseColor = 0xF4A6A6;
+const uint32_t edgeColor = 0x8C96A0;
+const uint32_t constrainedColor = 0x1F5FBF;
+const uint32_t steinerColor = 0xF08C00;
+
+// Maps the bounding box of the finite vertices onto the image, y pointing down
+struct Viewport {
+    double minX = 0, maxY = 0, scale = 1;
+    int width = 1, height = 1;
+    static const int margin = 10;
+
+    Viewport(const CDT& cdt, int imageWidth) {
+        double lowX = numeric_limits<double>::max(), lowY = lowX;
+        double highX = numeric_limits<double>::lowest(), highY = highX;
+        for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+            double x = CGAL::to_double(vertex->point().x());
+            double y = CGAL::to_double(vertex->point().y());
+            lowX = min(lowX, x);
+            highX = max(highX, x);
+            lowY = min(lowY, y);
+            highY = max(highY, y);
+        }
+        if (lowX > highX) {
+            lowX = highX = lowY = highY = 0;
+        }
+        double spanX = max(highX - lowX, 1e-9), spanY = max(highY - lowY, 1e-9);
+        width = max(imageWidth, 2 * margin + 1);
+        scale = (width - 2 * margin) / spanX;
+        height = max(2 * margin + 1, static_cast<int>(ceil(spanY * scale)) + 2 * margin);
+        minX = lowX;
+        maxY = highY;
+    }
+
+    double x(const Point& p) const { return margin + (CGAL::to_double(p.x()) - minX) * scale; }
+    double y(const Point& p) const { return margin + (maxY - CGAL::to_double(p.y())) * scale; }
+};
+
+struct ScreenFace {
+    double x[3], y[3];
+
+    ScreenFace(const Viewport& view, CDT::Face_handle face) {
+        for (int i = 0; i < 3; ++i) {
+            x[i] = view.x(face->vertex(i)->point());
+            y[i] = view.y(face->vertex(i)->point());
+        }
+    }
+    double extent() const {
+        return max(*max_element(x, x + 3) - *min_element(x, x + 3), *max_element(y, y + 3) - *min_element(y, y + 3));
+    }
+};
+
+bool isSteiner(CDT::Vertex_handle v, const RenderOptions& options) {
+    return v->info().id < 0 || static_cast<size_t>(v->info().id) >= options.input_points;
+}
+
+void writeNumber(BufferedWriter& out, double value) {
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%.2f", value);
+    out.write(text, static_cast<size_t>(length));
+}
+
+// Open a <path> element; the caller writes its "d" attribute and closes it
+void beginFillPath(BufferedWriter& out, uint32_t color) {
+    char element[64];
+    int length = snprintf(element, sizeof(element), "<path fill=\"#%06x\" stroke=\"none\" d=\"", static_cast<unsigned>(color));
+    out.write(element, static_cast<size_t>(length));
+}
+
+void beginStrokePath(BufferedWriter& out, uint32_t color, double width) {
+    char element[96];
+    int length = snprintf(element, sizeof(element), "<path fill=\"none\" stroke=\"#%06x\" stroke-width=\"%g\" d=\"",
+                          static_cast<unsigned>(color), width);
+    out.write(element, static_cast<size_t>(length));
+}
+
+void writeMoveTo(BufferedWriter& out, char command, double x, double y) {
+    out.put(command);
+    writeNumber(out, x);
+    out.put(' ');
+    writeNumber(out, y);
+}
+
+bool renderSvg(const CDT& cdt, const string& filename, const RenderOptions& options) {
+    Viewport view(cdt, options.width);
+    BufferedWriter out(filename, true);
+    if (!out.isOpen()) {
+        cerr << "Error writing SVG: cannot open " << filename << endl;
+        return false;
+    }
+    out.write("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+    out.writeInt(view.width);
+    out.write("\" height=\"");
+    out.writeInt(view.height);
+    out.write("\">\n");
+    beginFillPath(out, backgroundColor);
+    writeMoveTo(out, 'M', 0, 0);
+    out.write("H");
+    out.writeInt(view.width);
+    out.write("V");
+    out.writeInt(view.height);
+    out.write("H0Z\"/>\n");
+
+    // Faces, one subpath each; faces below the detail threshold only mark their pixel cell
+    vector<bool> cells(static_cast<size_t>(view.width) * view.height, false);
+    for (int pass = 0; pass < 2; ++pass) {
+        bool obtusePass = pass == 1;
+        beginFillPath(out, obtusePass ? obtuseColor : faceColor);
+        for (auto face = cdt.finite_faces_begin(); face != cdt.finite_faces_end(); ++face) {
+            if (obtuseFace(face, cdt) != obtusePass) {
+                continue;
+            }
+            ScreenFace screen(view, face);
+            if (!obtusePass && screen.extent() < options.min_feature_px) {
+                int cx = static_cast<int>((screen.x[0] + screen.x[1] + screen.x[2]) / 3);
+                int cy = static_cast<int>((screen.y[0] + screen.y[1] + screen.y[2]) / 3);
+                if (cx >= 0 && cy >= 0 && cx < view.width && cy < view.height) {
+                    cells[static_cast<size_t>(cy) * view.width + cx] = true;
+                }
+                continue;
+            }
+            writeMoveTo(out, 'M', screen.x[0], screen.y[0]);
+            writeMoveTo(out, 'L', screen.x[1], screen.y[1]);
+            writeMoveTo(out, 'L', screen.x[2], screen.y[2]);
+            out.put('Z');
+        }
+        out.write("\"/>\n");
+    }
+    beginFillPath(out, faceColor);
+    for (int cy = 0; cy < view.height; ++cy) {
+        for (int cx = 0; cx < view.width; ++cx) {
+            if (cells[static_cast<size_t>(cy) * view.width + cx]) {
+                writeMoveTo(out, 'M', cx, cy);
+                out.write("h1v1h-1Z");
+            }
+        }
+    }
+    out.write("\"/>\n");
+
+    // Edges: unconstrained ones only above the detail threshold, constrained ones always
+    for (int pass = 0; pass < 2; ++pass) {
+        bool constrainedPass = pass == 1;
+        if (constrainedPass) {
+            beginStrokePath(out, constrainedColor, 1.5);
+        } else {
+            beginStrokePath(out, edgeColor, 0.5);
+        }
+        for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
+            if (cdt.is_constrained(*edge) != constrainedPass) {
+                continue;
+            }
+            const Point& a = edge->first->vertex(CDT::ccw(edge->second))->point();
+            const Point& b = edge->first->vertex(CDT::cw(edge->second))->point();
+            double ax = view.x(a), ay = view.y(a), bx = view.x(b), by = view.y(b);
+            if (!constrainedPass && max(fabs(bx - ax), fabs(by - ay)) < options.min_feature_px) {
+                continue;
+            }
+            writeMoveTo(out, 'M', ax, ay);
+            writeMoveTo(out, 'L', bx, by);
+        }
+        out.write("\"/>\n");
+    }
+
+    // Steiner points, as small squares
+    beginFillPath(out, steinerColor);
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        if (isSteiner(vertex, options)) {
+            writeMoveTo(out, 'M', view.x(vertex->point()) - 1.5, view.y(vertex->point()) - 1.5);
+            out.write("h3v3h-3Z");
+        }
+    }
+    out.write("\"/>\n</svg>\n");
+
+    if (!out.close()) {
+        cerr << "Error writing SVG: write to " << filename << " failed" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool renderPng(const CDT& cdt, const string& filename, const RenderOptions& options) {
+    Viewport view(cdt, options.width);
+    Raster raster(view.width, view.height, backgroundColor);
+
+    for (auto face = cdt.finite_faces_begin(); face != cdt.finite_faces_end(); ++face) {
+        ScreenFace screen(view, face);
+        uint32_t color = obtuseFace(face, cdt) ? obtuseColor : faceColor;
+        if (screen.extent() < options.min_feature_px) {
+            raster.set(static_cast<int>((screen.x[0] + screen.x[1] + screen.x[2]) / 3),
+                       static_cast<int>((screen.y[0] + screen.y[1] + screen.y[2]) / 3), color);
+        } else {
+            raster.fillTriangle(screen.x[0], screen.y[0], screen.x[1], screen.y[1], screen.x[2], screen.y[2], color);
+        }
+    }
+    // Constrained edges last, so that they stay on top
+    for (int pass = 0; pass < 2; ++pass) {
+        bool constrainedPass = pass == 1;
+        for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
+            if (cdt.is_constrained(*edge) != constrainedPass) {
+                continue;
+            }
+            const Point& a = edge->first->vertex(CDT::ccw(edge->second))->point();
+            const Point& b = edge->first->vertex(CDT::cw(edge->second))->point();
+            double ax = view.x(a), ay = view.y(a), bx = view.x(b), by = view.y(b);
+            if (!constrainedPass && max(fabs(bx - ax), fabs(by - ay)) < 4 * options.min_feature_px) {
+                continue; // short edges would paint over the face colors
+            }
+            raster.line(ax, ay, bx, by, constrainedPass ? constrainedColor : edgeColor, constrainedPass ? 2 : 1);
+        }
+    }
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        if (isSteiner(vertex, options)) {
+            raster.dot(view.x(vertex->point()), view.y(vertex->point()), 1, steinerColor);
+        }
+    }
+    return raster.writePng(filename);
+}
+
+} // namespace
+
+bool renderTriangulation(const CDT& cdt, const string& filename, const RenderOptions& options) {
+    const string png = ".png";
+    bool isPng = filename.size() >= png.size() && filename.compare(filename.size() - png.size(), png.size(), png) == 0;
+    return isPng ? renderPng(cdt, filename, options) : renderSvg(cdt, filename, options);
+}
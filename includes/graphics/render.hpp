@@ -0,0 +1,24 @@
+#ifndef RENDER_HPP
+#define RENDER_HPP
+
+#include "utils.hpp"
+
+#include <string>
+
+using namespace std;
+
+// Headless rendering of a triangulation, for unattended runs (no display, never blocks)
+struct RenderOptions {
+    int width = 1600;            // image width in pixels; the height follows the aspect ratio
+    size_t input_points = 0;     // vertices with a smaller id are input points, all others Steiner points
+    double min_feature_px = 1.0; // level of detail: smaller faces and unconstrained edges are not drawn one by one
+};
+
+// Writes `cdt` as SVG or PNG, chosen by the extension of `filename` (.png, otherwise SVG).
+// Obtuse faces are filled red, constrained edges drawn blue and Steiner points as orange dots.
+// SVG is streamed face by face; faces below options.min_feature_px collapse into pixel cells, so
+// the file stays bounded by the image size however large the mesh. PNG rasterizes in memory.
+// Returns false if the file could not be written.
+bool renderTriangulation(const CDT& cdt, const string& filename, const RenderOptions& options = RenderOptions());
+
+#endif // RENDER_HPP
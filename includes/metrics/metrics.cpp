@@ -0,0 +1,127 @@
+#include "metrics.hpp"
+#include "output_writer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <unistd.h>
+
+using namespace std;
+
+size_t residentBytes() {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long size = 0, resident = 0;
+    int fields = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+    return fields == 2 ? resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+size_t peakResidentBytes() {
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) {
+        return 0;
+    }
+    char line[256];
+    unsigned long kilobytes = 0;
+    while (fgets(line, sizeof(line), status)) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            sscanf(line + 6, "%lu", &kilobytes);
+            break;
+        }
+    }
+    fclose(status);
+    return kilobytes * 1024;
+}
+
+string metricsPathFor(const string& solution_path) {
+    const string suffix = ".json";
+    if (solution_path.size() >= suffix.size() &&
+        solution_path.compare(solution_path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return solution_path.substr(0, solution_path.size() - suffix.size()) + ".metrics.json";
+    }
+    return solution_path + ".metrics.json";
+}
+
+static void writeCounter(BufferedWriter& out, const char* name, const atomic<uint64_t>& value) {
+    out.write(",\n    \"");
+    out.write(name);
+    out.write("\": ");
+    out.writeInt(static_cast<long long>(value.load(memory_order_relaxed)));
+}
+
+bool writeMetricsJson(const string& filename, const string& instance_uid, const Metrics& metrics,
+                      const vector<string>& strategy_names) {
+    BufferedWriter out(filename);
+    if (!out.isOpen()) {
+        cerr << "Error writing metrics: cannot open " << filename << endl;
+        return false;
+    }
+
+    out.write("{\n    \"instance_uid\": ");
+    out.writeJsonString(instance_uid);
+    writeCounter(out, "faces_scanned", metrics.faces_scanned);
+    writeCounter(out, "faces_filtered", metrics.faces_filtered);
+    writeCounter(out, "faces_exact", metrics.faces_exact);
+    writeCounter(out, "evaluations_skipped", metrics.evaluations_skipped);
+    writeCounter(out, "tentative_inserts", metrics.tentative_inserts);
+    writeCounter(out, "rollbacks", metrics.rollbacks);
+    writeCounter(out, "edge_flips", metrics.edge_flips);
+    writeCounter(out, "insertion_flips", metrics.insertion_flips);
+    writeCounter(out, "locate_calls", metrics.locate_calls);
+    writeCounter(out, "locate_walks", metrics.locate_walks);
+    writeCounter(out, "exact_fallbacks", metrics.exact_fallbacks);
+    writeCounter(out, "prescreen_rejects", metrics.prescreen_rejects);
+    writeCounter(out, "prescreen_promotions", metrics.prescreen_promotions);
+    writeCounter(out, "snapped_points", metrics.snapped_points);
+    writeCounter(out, "snap_rejects", metrics.snap_rejects);
+    writeCounter(out, "anneal_moves", metrics.anneal_moves);
+    writeCounter(out, "anneal_accepted", metrics.anneal_accepted);
+
+    // Per strategy: candidates built and insertions committed
+    out.write(",\n    \"strategies\": {");
+    for (size_t s = 0; s < strategy_names.size() && s < static_cast<size_t>(maxMetricStrategies); ++s) {
+        out.write(s == 0 ? "\n        " : ",\n        ");
+        out.writeJsonString(strategy_names[s]);
+        out.write(": {\"candidates\": ");
+        out.writeInt(static_cast<long long>(metrics.candidates[s].load(memory_order_relaxed)));
+        out.write(", \"wins\": ");
+        out.writeInt(static_cast<long long>(metrics.wins[s].load(memory_order_relaxed)));
+        out.put('}');
+    }
+    out.write(strategy_names.empty() ? "}" : "\n    }");
+
+    // Wall time per phase, in seconds
+    const char* phase_names[PHASE_COUNT] = {"read_json", "build", "edge_flips", "improve", "anneal", "write_output"};
+    out.write(",\n    \"phase_seconds\": {");
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        char seconds[32];
+        snprintf(seconds, sizeof(seconds), "%.6f", metrics.phase_ns[p].load(memory_order_relaxed) * 1e-9);
+        out.write(p == 0 ? "\n        \"" : ",\n        \"");
+        out.write(phase_names[p]);
+        out.write("\": ");
+        out.write(seconds);
+    }
+    out.write("\n    }");
+
+    // Memory: peak resident set sampled in each phase, and of the whole process so far
+    out.write(",\n    \"phase_peak_rss_bytes\": {");
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        out.write(p == 0 ? "\n        \"" : ",\n        \"");
+        out.write(phase_names[p]);
+        out.write("\": ");
+        out.writeInt(static_cast<long long>(metrics.phase_peak_rss[p].load(memory_order_relaxed)));
+    }
+    out.write("\n    },\n    \"peak_rss_bytes\": ");
+    out.writeInt(static_cast<long long>(peakResidentBytes()));
+    out.write("\n}\n");
+
+    if (!out.close()) {
+        cerr << "Error writing metrics: write to " << filename << " failed" << endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,139 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Solver telemetry: counters and phase timers of one run (one instance).
+// The code records into the Metrics installed on the current thread with METRIC_SCOPE;
+// worker threads install the Metrics of the instance they work for.
+// Without ENABLE_METRICS the METRIC_* macros compile to nothing.
+
+enum MetricPhase { PHASE_READ, PHASE_BUILD, PHASE_FLIPS, PHASE_IMPROVE, PHASE_ANNEAL, PHASE_WRITE, PHASE_COUNT };
+
+const int maxMetricStrategies = 8;
+
+struct Metrics {
+    atomic<uint64_t> faces_scanned{0};      // faces examined by the obtuse worklist
+    atomic<uint64_t> faces_filtered{0};     // faces the bulk classification settled in doubles
+    atomic<uint64_t> faces_exact{0};        // faces it left to the exact angle predicate
+    atomic<uint64_t> candidates[maxMetricStrategies] = {}; // candidates built and scored in the search kernel, per strategy
+    atomic<uint64_t> wins[maxMetricStrategies] = {};       // committed insertions, per strategy
+    atomic<uint64_t> evaluations_skipped{0}; // (face, strategy) evaluations the strategy scheduler avoided
+    atomic<uint64_t> tentative_inserts{0};
+    atomic<uint64_t> rollbacks{0};
+    atomic<uint64_t> edge_flips{0};         // flips of the flip engine
+    atomic<uint64_t> insertion_flips{0};    // Lawson flips of committed insertions
+    atomic<uint64_t> locate_calls{0};
+    atomic<uint64_t> locate_walks{0};       // locate calls that fell back to a full CDT::locate walk
+    atomic<uint64_t> exact_fallbacks{0};    // candidates rebuilt or re-checked with exact constructions
+    atomic<uint64_t> prescreen_rejects{0};  // candidates the interval pre-screen showed cannot improve
+    atomic<uint64_t> prescreen_promotions{0}; // candidates it passed on to exact evaluation (promising or uncertain)
+    atomic<uint64_t> snapped_points{0};     // Steiner points committed on the bounded-precision grid
+    atomic<uint64_t> snap_rejects{0};       // snapped points that left the face or lost the gain
+    atomic<uint64_t> anneal_moves{0};       // local-search moves proposed
+    atomic<uint64_t> anneal_accepted{0};
+    atomic<uint64_t> phase_ns[PHASE_COUNT] = {};
+    atomic<uint64_t> phase_peak_rss[PHASE_COUNT] = {}; // highest resident set sampled in each phase, bytes (whole process)
+    atomic<int> phase{-1};                  // phase being timed, which RSS samples are attributed to
+};
+
+// Resident set size of the process, from /proc/self/statm; 0 where that is unavailable
+size_t residentBytes();
+// Highest resident set size of the process so far (VmHWM); 0 where unavailable
+size_t peakResidentBytes();
+
+// Raises the current phase's peak to `bytes`
+inline void recordResident(Metrics& metrics, size_t bytes) {
+    int phase = metrics.phase.load(memory_order_relaxed);
+    if (phase < 0) {
+        return;
+    }
+    atomic<uint64_t>& peak = metrics.phase_peak_rss[phase];
+    uint64_t seen = peak.load(memory_order_relaxed);
+    while (seen < bytes && !peak.compare_exchange_weak(seen, bytes, memory_order_relaxed)) {
+    }
+}
+
+inline thread_local Metrics* current_metrics = nullptr;
+
+// Installs `metrics` on the current thread for the lifetime of the scope
+class MetricsScope {
+public:
+    explicit MetricsScope(Metrics* metrics) : previous_(current_metrics) { current_metrics = metrics; }
+    ~MetricsScope() { current_metrics = previous_; }
+    MetricsScope(const MetricsScope&) = delete;
+    MetricsScope& operator=(const MetricsScope&) = delete;
+
+private:
+    Metrics* previous_;
+};
+
+// Adds the lifetime of the scope to a phase of the current Metrics, and samples the
+// resident set at both ends of it (METRIC_RSS adds samples in between)
+class PhaseTimer {
+public:
+    explicit PhaseTimer(MetricPhase phase) : phase_(phase), start_(chrono::steady_clock::now()) {
+        if (current_metrics) {
+            previous_ = current_metrics->phase.exchange(phase, memory_order_relaxed);
+            recordResident(*current_metrics, residentBytes());
+        }
+    }
+    ~PhaseTimer() {
+        if (current_metrics) {
+            auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start_).count();
+            current_metrics->phase_ns[phase_].fetch_add(static_cast<uint64_t>(elapsed), memory_order_relaxed);
+            recordResident(*current_metrics, residentBytes());
+            current_metrics->phase.store(previous_, memory_order_relaxed);
+        }
+    }
+
+private:
+    MetricPhase phase_;
+    int previous_ = -1;
+    chrono::steady_clock::time_point start_;
+};
+
+#define METRIC_CONCAT_(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_(a, b)
+
+#ifdef ENABLE_METRICS
+#define METRIC_ADD(field, n) \
+    do { if (Metrics* metric_target_ = current_metrics) metric_target_->field.fetch_add((n), memory_order_relaxed); } while (0)
+#define METRIC_INC(field) METRIC_ADD(field, 1)
+#define METRIC_PHASE(phase) PhaseTimer METRIC_CONCAT(metric_phase_, __LINE__)(phase)
+#define METRIC_SCOPE(metrics) MetricsScope METRIC_CONCAT(metric_scope_, __LINE__)(metrics)
+#define METRIC_CURRENT() current_metrics
+#define METRIC_RSS(bytes) \
+    do { if (Metrics* metric_target_ = current_metrics) recordResident(*metric_target_, (bytes)); } while (0)
+#else
+#define METRIC_ADD(field, n) ((void)0)
+#define METRIC_INC(field) ((void)0)
+#define METRIC_PHASE(phase) ((void)0)
+#define METRIC_SCOPE(metrics) ((void)(metrics))
+#define METRIC_CURRENT() static_cast<Metrics*>(nullptr)
+#define METRIC_RSS(bytes) ((void)0)
+#endif
+
+constexpr bool metricsEnabled() {
+#ifdef ENABLE_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Sidecar path for a solution file: solution.json -> solution.metrics.json
+string metricsPathFor(const string& solution_path);
+
+// Writes the counters as JSON; strategy_names labels the per-strategy counters
+bool writeMetricsJson(const string& filename, const string& instance_uid, const Metrics& metrics,
+                      const vector<string>& strategy_names);
+
+#endif // METRICS_HPP
@@ -0,0 +1,364 @@
+#include "snapshot.hpp"
+#include "output_writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <gmpxx.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char kMagic[4] = {'C', 'G', 'S', 'S'};
+const uint32_t kVersion = 1;
+
+// Vertex and face handles are stable addresses, so they hash as pointers
+struct HandleHash {
+    template <class Handle> size_t operator()(const Handle& h) const {
+        return hash<const void*>()(static_cast<const void*>(&*h));
+    }
+};
+
+// Little-endian fields appended to an in-memory buffer
+class ByteBuffer {
+public:
+    void bytes(const void* data, size_t size) {
+        const char* begin = static_cast<const char*>(data);
+        data_.insert(data_.end(), begin, begin + size);
+    }
+    void u8(uint8_t value) { data_.push_back(static_cast<char>(value)); }
+    void u32(uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            u8(static_cast<uint8_t>(value >> shift));
+        }
+    }
+    void u64(uint64_t value) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            u8(static_cast<uint8_t>(value >> shift));
+        }
+    }
+    void i32(int32_t value) { u32(static_cast<uint32_t>(value)); }
+    void f64(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof bits);
+        u64(bits);
+    }
+    void text(const string& value) {
+        u32(static_cast<uint32_t>(value.size()));
+        bytes(value.data(), value.size());
+    }
+    // |z| as u32 length + bytes, least significant first
+    void magnitude(const mpz_class& z) {
+        size_t count = 0;
+        void* raw = mpz_export(nullptr, &count, -1, 1, 0, 0, z.get_mpz_t());
+        u32(static_cast<uint32_t>(count));
+        bytes(raw, count);
+        void (*release)(void*, size_t);
+        mp_get_memory_functions(nullptr, nullptr, &release);
+        release(raw, count);
+    }
+    void rational(const mpq_class& q) {
+        u8(sgn(q) < 0 ? 1 : 0);
+        magnitude(q.get_num());
+        magnitude(q.get_den());
+    }
+
+    const vector<char>& data() const { return data_; }
+    void reserve(size_t size) { data_.reserve(size); }
+
+private:
+    vector<char> data_;
+};
+
+// Bounds-checked cursor over the mapped file (read into memory if mapping fails)
+class ByteReader {
+public:
+    explicit ByteReader(const string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        opened_ = true;
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                ::madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                mapping_ = mapping;
+                size_ = static_cast<size_t>(info.st_size);
+                pos_ = static_cast<const unsigned char*>(mapping);
+            }
+        }
+        ::close(fd);
+        if (!mapping_) {
+            ifstream file(filename, ios::binary);
+            buffer_.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+            size_ = buffer_.size();
+            pos_ = reinterpret_cast<const unsigned char*>(buffer_.data());
+        }
+        end_ = pos_ + size_;
+    }
+    ~ByteReader() {
+        if (mapping_) {
+            ::munmap(mapping_, size_);
+        }
+    }
+    ByteReader(const ByteReader&) = delete;
+    ByteReader& operator=(const ByteReader&) = delete;
+
+    bool opened() const { return opened_; }
+    // Set by the first read past the end; every later read returns zeros
+    bool failed() const { return failed_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - pos_); }
+
+    const unsigned char* take(size_t size) {
+        if (failed_ || size > remaining()) {
+            failed_ = true;
+            return nullptr;
+        }
+        const unsigned char* data = pos_;
+        pos_ += size;
+        return data;
+    }
+    uint8_t u8() {
+        const unsigned char* data = take(1);
+        return data ? data[0] : 0;
+    }
+    uint32_t u32() {
+        const unsigned char* data = take(4);
+        uint32_t value = 0;
+        for (int i = 0; data && i < 4; ++i) {
+            value |= static_cast<uint32_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+    uint64_t u64() {
+        const unsigned char* data = take(8);
+        uint64_t value = 0;
+        for (int i = 0; data && i < 8; ++i) {
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    double f64() {
+        uint64_t bits = u64();
+        double value;
+        memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+    string text() {
+        uint32_t size = u32();
+        const unsigned char* data = take(size);
+        return data ? string(reinterpret_cast<const char*>(data), size) : string();
+    }
+    mpz_class magnitude() {
+        uint32_t size = u32();
+        const unsigned char* data = take(size);
+        mpz_class z;
+        if (data) {
+            mpz_import(z.get_mpz_t(), size, -1, 1, 0, 0, data);
+        }
+        return z;
+    }
+    mpq_class rational() {
+        bool negative = u8() != 0;
+        mpz_class num = magnitude();
+        mpz_class den = magnitude();
+        if (den == 0) {
+            failed_ = true;
+            return mpq_class(0);
+        }
+        mpq_class q(negative ? mpz_class(-num) : num, den);
+        q.canonicalize();
+        return q;
+    }
+
+private:
+    bool opened_ = false;
+    bool failed_ = false;
+    void* mapping_ = nullptr;
+    size_t size_ = 0;
+    const unsigned char* pos_ = nullptr;
+    const unsigned char* end_ = nullptr;
+    vector<char> buffer_;
+};
+
+} // namespace
+
+bool writeSnapshot(const string& filename, const CDT& cdt, const SnapshotInfo& info) {
+    if (cdt.dimension() != 2) {
+        cerr << "Error writing snapshot: the triangulation is not two-dimensional" << endl;
+        return false;
+    }
+
+    ByteBuffer buffer;
+    // Small-coordinate instances need about 16 bytes per coordinate and 25 per face
+    buffer.reserve(64 + cdt.number_of_vertices() * 40 + 2 * cdt.number_of_vertices() * 25);
+    buffer.bytes(kMagic, sizeof kMagic);
+    buffer.u32(kVersion);
+    buffer.text(info.instance_uid);
+    buffer.u32(info.input_points);
+    buffer.text(info.status);
+    buffer.f64(info.seconds);
+    buffer.i32(info.obtuse);
+
+    unordered_map<CDT::Vertex_handle, int32_t, HandleHash> vertexIndex;
+    vertexIndex.reserve(cdt.number_of_vertices());
+    buffer.u64(cdt.number_of_vertices());
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        int32_t index = static_cast<int32_t>(vertexIndex.size());
+        vertexIndex.emplace(vertex, index);
+        buffer.i32(vertex->info().id);
+        buffer.rational(CGAL::exact(vertex->point().x()));
+        buffer.rational(CGAL::exact(vertex->point().y()));
+    }
+
+    unordered_map<CDT::Face_handle, uint32_t, HandleHash> faceIndex;
+    for (auto face = cdt.all_faces_begin(); face != cdt.all_faces_end(); ++face) {
+        uint32_t index = static_cast<uint32_t>(faceIndex.size());
+        faceIndex.emplace(face, index);
+    }
+    buffer.u64(faceIndex.size());
+    for (auto face = cdt.all_faces_begin(); face != cdt.all_faces_end(); ++face) {
+        uint8_t constrained = 0;
+        for (int i = 0; i < 3; ++i) {
+            CDT::Vertex_handle vertex = face->vertex(i);
+            buffer.i32(cdt.is_infinite(vertex) ? -1 : vertexIndex[vertex]);
+        }
+        for (int i = 0; i < 3; ++i) {
+            buffer.u32(faceIndex[face->neighbor(i)]);
+            if (face->is_constrained(i)) {
+                constrained |= static_cast<uint8_t>(1u << i);
+            }
+        }
+        buffer.u8(constrained);
+    }
+
+    BufferedWriter out(filename, true);
+    if (!out.isOpen()) {
+        cerr << "Error writing snapshot: cannot open " << filename << endl;
+        return false;
+    }
+    out.write(buffer.data().data(), buffer.data().size());
+    if (!out.close()) {
+        cerr << "Error writing snapshot: write to " << filename << " failed" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool readSnapshot(const string& filename, CDT& cdt, SnapshotInfo& info) {
+    ByteReader in(filename);
+    if (!in.opened()) {
+        cerr << "Error reading snapshot: cannot open " << filename << endl;
+        return false;
+    }
+    auto fail = [&](const string& message) {
+        cerr << "Error reading snapshot " << filename << ": " << message << endl;
+        cdt.clear();
+        return false;
+    };
+
+    const unsigned char* magic = in.take(sizeof kMagic);
+    if (!magic || memcmp(magic, kMagic, sizeof kMagic) != 0) {
+        return fail("not a snapshot file");
+    }
+    uint32_t version = in.u32();
+    if (version != kVersion) {
+        return fail("unsupported version " + to_string(version));
+    }
+    info.instance_uid = in.text();
+    info.input_points = in.u32();
+    info.status = in.text();
+    info.seconds = in.f64();
+    info.obtuse = in.i32();
+
+    // Every vertex takes at least 24 bytes and every face 25: counts beyond that are damage
+    uint64_t numVertices = in.u64();
+    if (in.failed() || numVertices > in.remaining() / 24) {
+        return fail("truncated vertex table");
+    }
+    vector<Point> points;
+    vector<int> ids;
+    points.reserve(numVertices);
+    ids.reserve(numVertices);
+    for (uint64_t i = 0; i < numVertices && !in.failed(); ++i) {
+        ids.push_back(in.i32());
+        mpq_class x = in.rational();
+        mpq_class y = in.rational();
+        points.emplace_back(K::FT(x), K::FT(y));
+    }
+
+    uint64_t numFaces = in.u64();
+    if (in.failed() || numFaces > in.remaining() / 25) {
+        return fail("truncated face table");
+    }
+    // A triangulation of n points, infinite faces included, has exactly 2n - 4 faces
+    if (numVertices < 3 || numFaces != 2 * (numVertices + 1) - 4) {
+        return fail("face count does not match a 2D triangulation of " + to_string(numVertices) + " points");
+    }
+    vector<array<int, 3>> faces(numFaces), neighbors(numFaces);
+    vector<unsigned char> constrained(numFaces);
+    for (uint64_t k = 0; k < numFaces; ++k) {
+        for (int i = 0; i < 3; ++i) {
+            int32_t vertex = in.i32();
+            if (vertex < -1 || vertex >= static_cast<int64_t>(numVertices)) {
+                return fail("vertex index out of range in face " + to_string(k));
+            }
+            faces[k][i] = vertex;
+        }
+        for (int i = 0; i < 3; ++i) {
+            uint32_t neighbor = in.u32();
+            if (neighbor >= numFaces) {
+                return fail("neighbor index out of range in face " + to_string(k));
+            }
+            neighbors[k][i] = static_cast<int>(neighbor);
+        }
+        constrained[k] = in.u8();
+    }
+    if (in.failed()) {
+        return fail("unexpected end of file");
+    }
+
+    // Adjacency must be mutual and agree on the shared edge, and every vertex must have a face,
+    // or the rebuilt TDS would be corrupt
+    vector<char> used(numVertices + 1, 0);
+    for (uint64_t k = 0; k < numFaces; ++k) {
+        for (int i = 0; i < 3; ++i) {
+            used[faces[k][i] + 1] = 1;
+            const auto& other = faces[neighbors[k][i]];
+            int a = faces[k][(i + 1) % 3], b = faces[k][(i + 2) % 3];
+            bool mutual = false;
+            for (int j = 0; j < 3; ++j) {
+                if (neighbors[neighbors[k][i]][j] == static_cast<int>(k) &&
+                    other[(j + 1) % 3] == b && other[(j + 2) % 3] == a) {
+                    mutual = true;
+                }
+            }
+            if (!mutual) {
+                return fail("inconsistent adjacency at face " + to_string(k));
+            }
+        }
+    }
+
+    if (find(used.begin(), used.end(), 0) != used.end()) {
+        return fail("a vertex belongs to no face");
+    }
+
+    vector<CDT::Vertex_handle> handles;
+    cdt.rebuild(points, faces, neighbors, constrained, handles);
+    for (size_t i = 0; i < handles.size(); ++i) {
+        handles[i]->info().id = ids[i];
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include "utils.hpp"
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Solver progress stored with a snapshot
+struct SnapshotInfo {
+    string instance_uid;
+    uint32_t input_points = 0; // vertices with a smaller id are input points, the rest Steiner points
+    string status;             // status of the solve that wrote it
+    double seconds = 0;        // solve time spent so far
+    int obtuse = -1;           // obtuse angles at the time of the snapshot
+};
+
+// Binary snapshot of a triangulation, to resume a solve or warm-start another one
+// without re-inserting any point. All fields little-endian:
+//   "CGSS" u32 version=1, u32 uid length + bytes, u32 input points, u32 status length + bytes,
+//   f64 seconds, i32 obtuse,
+//   u64 vertex count, per finite vertex: i32 id, x and y as exact rationals,
+//   u64 face count, per face (infinite ones included): 3 x i32 vertex index (-1 = infinite vertex),
+//   3 x u32 neighbor face index, u8 constrained edge bits.
+// A rational is u8 sign (0 or 1 = negative), u32 length + bytes of |numerator|,
+// u32 length + bytes of the denominator, magnitudes least significant byte first.
+// The file is assembled in memory and written in one call, atomically replacing `filename`.
+bool writeSnapshot(const string& filename, const CDT& cdt, const SnapshotInfo& info);
+
+// Maps the file and rebuilds `cdt` straight from the stored faces and neighbors (no point
+// location, no flips). The indices are checked, so a damaged file fails cleanly instead of
+// producing a broken triangulation; on failure `cdt` is left empty.
+bool readSnapshot(const string& filename, CDT& cdt, SnapshotInfo& info);
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,1226 @@
+#include "solver.hpp"
+#include "strategies.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+
+using namespace std;
+
+WorkerPool::WorkerPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkerPool::drain() {
+    for (size_t i = next_++; i < count_; i = next_++) {
+        (*task_)(i);
+    }
+}
+
+void WorkerPool::run(size_t count, const function<void(size_t)>& task) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        next_ = 0;
+        active_ = workers_.size();
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    drain();
+
+    unique_lock<mutex> lock(mutex_);
+    done_.wait(lock, [this] { return active_ == 0; });
+}
+
+void WorkerPool::workerLoop() {
+    unsigned seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        drain();
+
+        lock_guard<mutex> lock(mutex_);
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+namespace {
+
+const size_t numStrategies = SteinerStrategies::size;
+static_assert(numStrategies <= static_cast<size_t>(maxMetricStrategies), "raise maxMetricStrategies for the new strategies");
+
+// Success statistics of the strategies on one instance: a strategy succeeds on a face when its
+// candidate lowers the obtuse count. The evaluation order is by UCB1 score (success rate plus an
+// exploration bonus that shrinks as a strategy gets tried), untried strategies first.
+// With skip_below > 0, a strategy whose optimistic rate (the UCB1 score) has fallen below it
+// is left out; the bonus grows with the total number of trials, so it is retried now and then.
+class StrategyScheduler {
+public:
+    explicit StrategyScheduler(double skip_below) : skip_below_(skip_below) {
+        update();
+    }
+
+    // Strategies to evaluate, most promising first
+    const vector<size_t>& order() const { return order_; }
+
+    void record(size_t strategy, bool improved) {
+        ++trials_[strategy];
+        ++total_;
+        if (improved) {
+            ++successes_[strategy];
+        }
+    }
+
+    // Recomputes the order from the statistics so far; called between rounds
+    void update() {
+        double score[numStrategies];
+        order_.clear();
+        for (size_t s = 0; s < numStrategies; ++s) {
+            score[s] = trials_[s] == 0 ? numeric_limits<double>::infinity()
+                     : static_cast<double>(successes_[s]) / trials_[s] + sqrt(2 * log(static_cast<double>(total_)) / trials_[s]);
+            order_.push_back(s);
+        }
+        stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) { return score[a] > score[b]; });
+        // The best one always stays
+        while (skip_below_ > 0 && order_.size() > 1 && trials_[order_.back()] >= kMinTrials && score[order_.back()] < skip_below_) {
+            order_.pop_back();
+        }
+    }
+
+private:
+    static const uint64_t kMinTrials = 32;
+
+    double skip_below_;
+    uint64_t trials_[numStrategies] = {};
+    uint64_t successes_[numStrategies] = {};
+    uint64_t total_ = 0;
+    vector<size_t> order_;
+};
+
+typedef array<CDT::Vertex_handle, 3> FaceKey;
+
+// A strategy's candidate with its score; the point, its location and the strategy come from SteinerCandidate
+struct Candidate : SteinerCandidate<Point> {
+    bool evaluated = false;
+    int delta = 0;
+    vector<CDT::Vertex_handle> region; // vertices of the faces in the conflict region
+};
+
+// Strategy `strategy` on `face` in interval arithmetic: true if that settles the candidate's
+// obtuse delta, which is then the exact one (0 when the strategy has no point for the face)
+bool prescreenCandidate(const CDT& cdt, CDT::Face_handle face, size_t strategy, int& delta) {
+    CGAL::Protect_FPU_rounding<true> rounding;
+    try {
+        SteinerCandidate<IntervalConstructions::Candidate> steiner;
+        if (!SteinerStrategies::compute<IntervalConstructions>(strategy, face, cdt, steiner)) {
+            delta = 0;
+            return true;
+        }
+        return intervalObtuseDelta(cdt, steiner.point, face, delta);
+    } catch (const CGAL::Uncertain_conversion_exception&) {
+        return false;
+    }
+}
+
+// Read-only over the triangulation, safe to run concurrently. With `prescreen`, a candidate that
+// interval arithmetic shows cannot improve is scored without exact constructions; only the
+// promising and the uncertain ones go on to the exact evaluation.
+template <class KernelPolicy>
+void evaluateCandidate(const CDT& cdt, CDT::Face_handle face, size_t strategy, bool prescreen, Candidate& candidate) {
+    candidate.evaluated = true;
+    if (prescreen) {
+        int delta = 0;
+        if (prescreenCandidate(cdt, face, strategy, delta) && delta >= 0) {
+            METRIC_INC(prescreen_rejects);
+            candidate.delta = delta;
+            return;
+        }
+        METRIC_INC(prescreen_promotions);
+    }
+    if (!SteinerStrategies::compute<KernelPolicy>(strategy, face, cdt, candidate)) {
+        return;
+    }
+    METRIC_INC(candidates[strategy]);
+
+    // Located once, here or by the strategy: the conflict region and the commit reuse it
+    if (!candidate.located()) {
+        candidate.face = locateNear(cdt, candidate.point, face, candidate.lt, candidate.li);
+    }
+    vector<CDT::Face_handle> conflicts;
+    vector<CDT::Edge> boundary;
+    steinerConflictRegion(cdt, candidate.point, candidate.lt, candidate.face, candidate.li, conflicts, boundary);
+    candidate.delta = regionObtuseDelta(cdt, candidate.point, conflicts, boundary);
+
+    if (candidate.delta < 0) {
+        for (const auto& conflict : conflicts) {
+            for (int i = 0; i < 3; ++i) {
+                candidate.region.push_back(conflict->vertex(i));
+            }
+        }
+    }
+}
+
+// Rough size of the triangulation: its faces and vertices with their lazy-exact coordinates
+size_t estimatedBytes(const CDT& cdt) {
+    const size_t coordinateBytes = 2 * 64;
+    return cdt.number_of_faces() * sizeof(CDT::Face) +
+           cdt.number_of_vertices() * (sizeof(CDT::Vertex) + coordinateBytes);
+}
+
+atomic<bool> stopFlag{false};
+
+// Samples the resident set (for the per-phase peaks) and checks it against options.rss_limit_mb
+bool residentLimitReached(const SolverOptions& options) {
+    if (options.rss_limit_mb == 0 && !metricsEnabled()) {
+        return false;
+    }
+    size_t rss = residentBytes();
+    METRIC_RSS(rss);
+    return options.rss_limit_mb > 0 && rss >= options.rss_limit_mb * 1024 * 1024;
+}
+
+// Computes the exact coordinates of a committed point, which lets CGAL drop the lazy
+// construction DAG behind them (the candidate geometry it was built from)
+void compactPoint(const Point& p) {
+    CGAL::exact(p);
+}
+
+// True once every options.checkpoint_interval seconds; restarts the interval at `last`
+bool checkpointDue(const SolverOptions& options, chrono::steady_clock::time_point& last) {
+    if (!options.checkpoint || options.checkpoint_interval <= 0) {
+        return false;
+    }
+    auto now = chrono::steady_clock::now();
+    if (chrono::duration<double>(now - last).count() < options.checkpoint_interval) {
+        return false;
+    }
+    last = now;
+    return true;
+}
+
+} // namespace
+
+void requestStop() {
+    stopFlag.store(true, memory_order_relaxed);
+}
+
+bool stopRequested() {
+    return stopFlag.load(memory_order_relaxed);
+}
+
+vector<string> strategyNames() {
+    vector<string> names;
+    for (size_t s = 0; s < numStrategies; ++s) {
+        names.push_back(SteinerStrategies::name(s));
+    }
+    return names;
+}
+
+int improveTriangulation(CDT& cdt, TriangulationData& data, const SolverOptions& options, string* status,
+                         const vector<CDT::Face_handle>* seedFaces) {
+    WorkerPool pool(max(1u, options.threads));
+    int obtuseCount = countObtuseAngles(cdt);
+    string stopReason = "converged";
+
+    auto start = chrono::steady_clock::now();
+    auto timeUp = [&] {
+        return options.time_limit > 0 &&
+               chrono::duration<double>(chrono::steady_clock::now() - start).count() >= options.time_limit;
+    };
+    auto memoryFull = [&] {
+        return (options.memory_limit_mb > 0 && estimatedBytes(cdt) >= options.memory_limit_mb * 1024 * 1024) ||
+               residentLimitReached(options);
+    };
+
+    // Worklist των αμβλυγώνιων τριγώνων: αρχικά όλα, μετά μόνο όσα αγγίζει κάθε εισαγωγή
+    ObtuseWorklist worklist;
+    if (seedFaces) {
+        worklist.seed(cdt, *seedFaces);
+    } else {
+        worklist.seed(cdt);
+    }
+
+    // Οι Steiner κορυφές αριθμούνται αμέσως μετά τις ήδη αριθμημένες (σημεία εισόδου και προηγούμενα Steiner)
+    int nextVertexId = 0;
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        nextVertexId = max(nextVertexId, vertex->info().id + 1);
+    }
+
+    vector<FaceKey> batch;
+    vector<CDT::Face_handle> batchFaces;
+    vector<Candidate> candidates;
+    StrategyScheduler scheduler(options.strategy_skip);
+
+    // The greedy loop only commits improvements: the live state is always the best one so far
+    auto lastCheckpoint = start;
+
+    while (true) {
+        if (timeUp()) {
+            stopReason = "time_limit";
+            break;
+        }
+        if (memoryFull()) {
+            stopReason = "memory_limit";
+            break;
+        }
+        if (stopRequested()) {
+            stopReason = "interrupted";
+            break;
+        }
+        if (checkpointDue(options, lastCheckpoint)) {
+            options.checkpoint(cdt, data);
+        }
+
+        batch.clear();
+        batchFaces.clear();
+        CDT::Face_handle face;
+        while (batch.size() < max<size_t>(1, options.batch_size) && worklist.pop(cdt, face)) {
+            batch.push_back({{face->vertex(0), face->vertex(1), face->vertex(2)}});
+            batchFaces.push_back(face);
+        }
+        if (batch.empty()) {
+            break;
+        }
+
+        // Parallel evaluation against the unchanged triangulation; candidates[i * numStrategies + s] is
+        // strategy s on face i. Every scheduled strategy gets its own slot, or, adaptively, each face is
+        // one slot that tries them in the scheduler's order and stops at the first improving candidate.
+        candidates.assign(batch.size() * numStrategies, Candidate());
+        const vector<size_t>& order = scheduler.order();
+        auto evaluate = [&](size_t i, size_t strategy) {
+            Candidate& candidate = candidates[i * numStrategies + strategy];
+            if (options.inexact_constructions) {
+                evaluateCandidate<InexactConstructions>(cdt, batchFaces[i], strategy, false, candidate);
+            } else {
+                evaluateCandidate<ExactConstructions>(cdt, batchFaces[i], strategy, options.prescreen, candidate);
+            }
+            return candidate.delta < 0;
+        };
+        Metrics* metrics = METRIC_CURRENT();
+        if (options.adaptive_strategies) {
+            pool.run(batch.size(), [&](size_t i) {
+                METRIC_SCOPE(metrics); // pool threads count into this instance
+                for (size_t strategy : order) {
+                    if (evaluate(i, strategy)) {
+                        break;
+                    }
+                }
+            });
+        } else {
+            pool.run(batch.size() * order.size(), [&](size_t k) {
+                METRIC_SCOPE(metrics);
+                evaluate(k / order.size(), order[k % order.size()]);
+            });
+        }
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            if (candidates[k].evaluated) {
+                scheduler.record(k % numStrategies, candidates[k].delta < 0);
+            } else {
+                METRIC_INC(evaluations_skipped);
+            }
+        }
+        scheduler.update();
+
+        // Single committer, in batch order
+        set<CDT::Vertex_handle> touched;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const Candidate* best = nullptr;
+            for (size_t s = 0; s < numStrategies; ++s) {
+                const Candidate& candidate = candidates[i * numStrategies + s];
+                if (candidate.delta < (best ? best->delta : 0)) {
+                    best = &candidate;
+                }
+            }
+
+            // Χωρίς βελτίωση το τρίγωνο βγαίνει από τη λίστα, μέχρι κάποια εισαγωγή να αλλάξει τη γειτονιά του
+            if (!best) {
+                continue;
+            }
+
+            // Earlier commits may have deleted or reused the face handle
+            if (!cdt.is_face(batch[i][0], batch[i][1], batch[i][2], face)) {
+                continue;
+            }
+
+            // The candidate was scored before an earlier commit changed its conflict region: retry next round
+            bool stale = false;
+            for (const auto& v : best->region) {
+                if (touched.count(v)) {
+                    stale = true;
+                    break;
+                }
+            }
+            if (stale) {
+                worklist.push(cdt, face);
+                continue;
+            }
+
+            // A double candidate only ranked the strategies: rebuild the winner with exact constructions.
+            // An exact candidate's location is still valid: its faces are in the region checked above.
+            SteinerCandidate<Point> winner = *best;
+            size_t bestStrategy = best->strategy;
+            if (options.inexact_constructions) {
+                METRIC_INC(exact_fallbacks);
+                if (!SteinerStrategies::compute<ExactConstructions>(bestStrategy, face, cdt, winner)) {
+                    continue;
+                }
+            }
+            Point steinerPoint = winner.point;
+
+            // Bounded precision: the point snapped to the grid goes first, if it still lies in the face;
+            // when it loses the gain the exact point gets its own attempt
+            Point attempts[2] = {steinerPoint, steinerPoint};
+            int numAttempts = 1;
+            if (options.snap_bits > 0) {
+                Point grid = snapToGrid(steinerPoint, options.snap_bits);
+                if (grid != steinerPoint && cdt.triangle(face).bounded_side(grid) != CGAL::ON_UNBOUNDED_SIDE) {
+                    attempts[0] = grid;
+                    numAttempts = 2;
+                } else if (grid != steinerPoint) {
+                    METRIC_INC(snap_rejects);
+                }
+            }
+
+            // The insertion is applied tentatively and kept only if its exact effect confirms the gain
+            CDT::Vertex_handle steiner;
+            int delta = 0;
+            for (int a = 0; a < numAttempts; ++a) {
+                if (a > 0) {
+                    METRIC_INC(snap_rejects);
+                    if (!cdt.is_face(batch[i][0], batch[i][1], batch[i][2], face)) {
+                        break;
+                    }
+                }
+                cdt.checkpoint();
+                // The unsnapped point goes in where it was located; a grid point, or anything after a rollback, is located again
+                if (numAttempts == 1 && winner.located()) {
+                    steiner = cdt.tentative_insert(attempts[a], winner.lt, winner.face, winner.li);
+                } else {
+                    steiner = cdt.tentative_insert(attempts[a], face);
+                }
+                METRIC_INC(tentative_inserts);
+                delta = insertionObtuseDelta(cdt, cdt.last_insert());
+                if (delta < 0) {
+                    steinerPoint = attempts[a];
+                    if (a + 1 < numAttempts) {
+                        METRIC_INC(snapped_points);
+                    }
+                    break;
+                }
+                cdt.rollback();
+                METRIC_INC(rollbacks);
+            }
+            if (delta >= 0) {
+                continue;
+            }
+            METRIC_INC(wins[bestStrategy]);
+            METRIC_ADD(insertion_flips, cdt.last_insert().flips.size());
+            for (const auto& vertices : cdt.last_insert().destroyed_faces) {
+                touched.insert(vertices.begin(), vertices.end());
+            }
+            touched.insert(steiner);
+            cdt.commit();
+            steiner->info().id = nextVertexId++;
+            compactPoint(steiner->point());
+
+            data.steiner_points.push_back(steinerPoint);
+            obtuseCount += delta;
+            if (options.verbose) {
+                cout << "Improvement with " << SteinerStrategies::name(bestStrategy) << ", new obtuse angle count: " << obtuseCount << endl;
+            }
+
+            // Only the region around the new vertex changed
+            worklist.update(cdt, steiner);
+
+            if (options.obtuse_flips) {
+                FlipReport flips;
+                performEdgeFlipsAround(cdt, steiner, shouldFlipObtuse, &flips);
+                for (const auto& flipped : flips.faces) {
+                    touched.insert(flipped->vertex(0));
+                    touched.insert(flipped->vertex(1));
+                    touched.insert(flipped->vertex(2));
+                    worklist.push(cdt, flipped);
+                }
+                obtuseCount += flips.obtuse_delta;
+            }
+        }
+
+        // The losing candidates' geometry is not needed any more
+        candidates.clear();
+    }
+    if (options.verbose) {
+        if (stopReason == "converged") {
+            cout << "No further improvement is possible." << endl;
+        } else {
+            cout << "Stopped early: " << stopReason << endl;
+        }
+    }
+    if (status) {
+        *status = stopReason;
+    }
+
+    return obtuseCount;
+}
+
+// p snapped to the 2^-bits grid if the snapped point is still in `face`, otherwise p itself
+static Point snapInFace(const CDT& cdt, CDT::Face_handle face, const Point& p, int bits) {
+    if (bits <= 0) {
+        return p;
+    }
+    Point grid = snapToGrid(p, bits);
+    if (grid != p && cdt.triangle(face).bounded_side(grid) == CGAL::ON_UNBOUNDED_SIDE) {
+        METRIC_INC(snap_rejects);
+        return p;
+    }
+    return grid;
+}
+
+// Obtuse finite faces incident to any of `vertices`, each counted once
+static int obtuseAround(const CDT& cdt, const vector<CDT::Vertex_handle>& vertices) {
+    FaceVisitor visitor(cdt);
+    int obtuse = 0;
+    for (const auto& v : vertices) {
+        CDT::Face_circulator fc = cdt.incident_faces(v), done(fc);
+        do {
+            if (visitor.visit(fc) && !cdt.is_infinite(fc) && obtuseFace(fc, cdt)) {
+                ++obtuse;
+            }
+        } while (++fc != done);
+    }
+    return obtuse;
+}
+
+// Finite neighbours of v: every face that removing v changes is incident to one of them
+static vector<CDT::Vertex_handle> finiteNeighbours(const CDT& cdt, CDT::Vertex_handle v) {
+    vector<CDT::Vertex_handle> neighbours;
+    CDT::Vertex_circulator vc = cdt.incident_vertices(v), done(vc);
+    do {
+        if (!cdt.is_infinite(vc)) {
+            neighbours.push_back(vc);
+        }
+    } while (++vc != done);
+    return neighbours;
+}
+
+// Removes v and returns the change in obtuse angles
+static int removeScored(CDT& cdt, CDT::Vertex_handle v) {
+    vector<CDT::Vertex_handle> neighbours = finiteNeighbours(cdt, v);
+    int before = obtuseAround(cdt, neighbours);
+    cdt.remove(v);
+    return obtuseAround(cdt, neighbours) - before;
+}
+
+// Inserts p for good and returns the new vertex; `delta` receives the change in obtuse angles
+static CDT::Vertex_handle insertScored(CDT& cdt, const Point& p, CDT::Face_handle hint, int& delta) {
+    cdt.checkpoint();
+    CDT::Vertex_handle v = cdt.tentative_insert(p, hint);
+    delta = insertionObtuseDelta(cdt, cdt.last_insert());
+    cdt.commit();
+    compactPoint(v->point());
+    return v;
+}
+
+// Makes `points` the Steiner points of cdt: Steiner vertices (handles in `steiner`) that are not
+// among them are removed and the missing ones inserted, then they are numbered from firstSteinerId
+// in the order of `points`. The triangulation follows from the point set, like every other insertion.
+// A vertex that splits a constraint cannot be removed from the CDT: such vertices stay, after
+// `points`, and the result is false because the point set is then not exactly `points`.
+static bool restoreSteinerPoints(CDT& cdt, vector<CDT::Vertex_handle>& steiner, const vector<Point>& points, int firstSteinerId) {
+    set<Point> wanted(points.begin(), points.end());
+    map<Point, CDT::Vertex_handle> kept;
+    vector<CDT::Vertex_handle> pinned;
+    for (const auto& v : steiner) {
+        if (wanted.count(v->point())) {
+            kept[v->point()] = v;
+        } else if (cdt.are_there_incident_constraints(v)) {
+            pinned.push_back(v);
+        } else {
+            cdt.remove(v);
+        }
+    }
+    steiner.clear();
+    for (const auto& p : points) {
+        auto found = kept.find(p);
+        if (found != kept.end()) {
+            steiner.push_back(found->second);
+        } else {
+            int delta;
+            steiner.push_back(insertScored(cdt, p, steiner.empty() ? CDT::Face_handle() : steiner.back()->face(), delta));
+        }
+        steiner.back()->info().id = firstSteinerId + static_cast<int>(steiner.size() - 1);
+    }
+    for (const auto& v : pinned) {
+        steiner.push_back(v);
+        v->info().id = firstSteinerId + static_cast<int>(steiner.size() - 1);
+    }
+    return pinned.empty();
+}
+
+int annealTriangulation(CDT& cdt, TriangulationData& data, const SolverOptions& options, string* status) {
+    int obtuseCount = countObtuseAngles(cdt);
+    string stopReason = "converged";
+    auto start = chrono::steady_clock::now();
+    mt19937_64 rng(options.seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    const double t0 = max(1e-9, options.anneal_t0);
+    const double t1 = max(1e-9, options.anneal_t1);
+
+    // The Steiner vertices, in output order: numbered right after the input points
+    int nextVertexId = 0;
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        nextVertexId = max(nextVertexId, vertex->info().id + 1);
+    }
+    const int firstSteinerId = nextVertexId - static_cast<int>(data.steiner_points.size());
+    vector<CDT::Vertex_handle> steiner(data.steiner_points.size());
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        if (vertex->info().id >= firstSteinerId && vertex->info().id - firstSteinerId < static_cast<int>(steiner.size())) {
+            steiner[vertex->info().id - firstSteinerId] = vertex;
+        }
+    }
+
+    // Obtuse faces to insert into, refreshed by a scan whenever the sample runs dry
+    vector<FaceKey> obtuseFaces;
+    auto refresh = [&] {
+        obtuseFaces.clear();
+        FaceClassification classification;
+        classifyFaces(cdt, &classification);
+        for (size_t k = 0; k < classification.faces.size(); ++k) {
+            if (classification.obtuse_vertex[k] >= 0) {
+                CDT::Face_handle face = classification.faces[k];
+                obtuseFaces.push_back({{face->vertex(0), face->vertex(1), face->vertex(2)}});
+            }
+        }
+    };
+
+    // Best state seen, kept as its Steiner point set: copied only when the energy reaches a new low
+    auto energy = [&] { return obtuseCount + options.steiner_weight * steiner.size(); };
+    double bestEnergy = energy();
+    vector<Point> bestPoints = data.steiner_points;
+    auto trackBest = [&] {
+        if (energy() < bestEnergy) {
+            bestEnergy = energy();
+            bestPoints.clear();
+            for (const auto& v : steiner) {
+                bestPoints.push_back(v->point());
+            }
+        }
+    };
+    // Checkpoints materialize the best state on a copy; the live ids have gaps from removed vertices.
+    // When the copy cannot reproduce it (a later move split a constraint) the checkpoint is skipped.
+    auto lastCheckpoint = start;
+    auto writeCheckpoint = [&] {
+        CDT best(cdt);
+        vector<CDT::Vertex_handle> bestSteiner;
+        for (auto vertex = best.finite_vertices_begin(); vertex != best.finite_vertices_end(); ++vertex) {
+            if (vertex->info().id >= firstSteinerId) {
+                bestSteiner.push_back(vertex);
+            }
+        }
+        if (!restoreSteinerPoints(best, bestSteiner, bestPoints, firstSteinerId)) {
+            return;
+        }
+        TriangulationData bestData;
+        bestData.steiner_points = bestPoints;
+        options.checkpoint(best, bestData);
+    };
+
+    for (size_t step = 0; step < options.anneal_steps; ++step) {
+        trackBest();
+        if (options.time_limit > 0 &&
+            chrono::duration<double>(chrono::steady_clock::now() - start).count() >= options.time_limit) {
+            stopReason = "time_limit";
+            break;
+        }
+        if (stopRequested()) {
+            stopReason = "interrupted";
+            break;
+        }
+        if (step % 256 == 0 && residentLimitReached(options)) {
+            stopReason = "memory_limit";
+            break;
+        }
+        if (checkpointDue(options, lastCheckpoint)) {
+            writeCheckpoint();
+        }
+        double progress = static_cast<double>(step) / options.anneal_steps;
+        double temperature = t0 * pow(t1 / t0, progress);
+        auto accept = [&](double energyDelta) {
+            return energyDelta <= 0 || unit(rng) < exp(-energyDelta / temperature);
+        };
+        METRIC_INC(anneal_moves);
+
+        double roll = unit(rng);
+        if (steiner.empty() || roll < 0.4) {
+            //////////////////// Insert ////////////////////
+            if (obtuseFaces.empty()) {
+                refresh();
+                if (obtuseFaces.empty()) {
+                    break; // nothing left to improve
+                }
+            }
+            size_t pick = rng() % obtuseFaces.size();
+            FaceKey key = obtuseFaces[pick];
+            obtuseFaces[pick] = obtuseFaces.back();
+            obtuseFaces.pop_back();
+            CDT::Face_handle face;
+            if (!cdt.is_face(key[0], key[1], key[2], face) || !obtuseFace(face, cdt)) {
+                continue;
+            }
+            SteinerCandidate<Point> candidate;
+            if (!SteinerStrategies::compute<ExactConstructions>(rng() % numStrategies, face, cdt, candidate)) {
+                continue;
+            }
+            Point point = snapInFace(cdt, face, candidate.point, options.snap_bits);
+
+            cdt.checkpoint();
+            CDT::Vertex_handle v = options.snap_bits <= 0 && candidate.located()
+                                       ? cdt.tentative_insert(point, candidate.lt, candidate.face, candidate.li)
+                                       : cdt.tentative_insert(point, face);
+            METRIC_INC(tentative_inserts);
+            if (cdt.last_insert().lt == CDT::VERTEX) {
+                cdt.rollback();
+                continue;
+            }
+            int delta = insertionObtuseDelta(cdt, cdt.last_insert());
+            if (!accept(delta + options.steiner_weight)) {
+                cdt.rollback();
+                METRIC_INC(rollbacks);
+                continue;
+            }
+            cdt.commit();
+            v->info().id = nextVertexId++;
+            compactPoint(v->point());
+            steiner.push_back(v);
+            obtuseCount += delta;
+            METRIC_INC(anneal_accepted);
+            continue;
+        }
+
+        size_t k = rng() % steiner.size();
+        CDT::Vertex_handle v = steiner[k];
+        if (cdt.are_there_incident_constraints(v)) {
+            continue;
+        }
+        Point old = v->point();
+        int id = v->info().id;
+
+        if (roll < 0.8) {
+            //////////////////// Relocate ////////////////////
+            // Target: a strategy point of a random obtuse face of the star, otherwise its centroid
+            vector<CDT::Face_handle> star;
+            CDT::Face_circulator fc = cdt.incident_faces(v), done(fc);
+            do {
+                if (!cdt.is_infinite(fc)) {
+                    star.push_back(fc);
+                }
+            } while (++fc != done);
+            if (star.empty()) {
+                continue;
+            }
+            CDT::Face_handle face = star[rng() % star.size()];
+            // Removing v invalidates the candidate's location: only its point is used
+            SteinerCandidate<Point> candidate;
+            Point target;
+            if (obtuseFace(face, cdt) &&
+                SteinerStrategies::compute<ExactConstructions>(rng() % numStrategies, face, cdt, candidate)) {
+                target = candidate.point;
+            } else {
+                target = CGAL::centroid(face->vertex(0)->point(), face->vertex(1)->point(), face->vertex(2)->point());
+            }
+            target = snapInFace(cdt, face, target, options.snap_bits);
+            // The target lies in the star of v, which removing v turns into its hole
+            CDT::Vertex_handle anchor = face->vertex(CDT::ccw(face->index(v)));
+
+            int removed = removeScored(cdt, v);
+            cdt.checkpoint();
+            CDT::Vertex_handle moved = cdt.tentative_insert(target, anchor->face());
+            METRIC_INC(tentative_inserts);
+            int inserted = cdt.last_insert().lt == CDT::VERTEX ? 0 : insertionObtuseDelta(cdt, cdt.last_insert());
+            if (cdt.last_insert().lt != CDT::VERTEX && accept(removed + inserted)) {
+                cdt.commit();
+                moved->info().id = id;
+                compactPoint(moved->point());
+                steiner[k] = moved;
+                obtuseCount += removed + inserted;
+                METRIC_INC(anneal_accepted);
+                continue;
+            }
+            cdt.rollback();
+            METRIC_INC(rollbacks);
+            int restored;
+            steiner[k] = insertScored(cdt, old, anchor->face(), restored);
+            steiner[k]->info().id = id;
+            obtuseCount += removed + restored;
+        } else {
+            //////////////////// Remove ////////////////////
+            CDT::Vertex_handle anchor = finiteNeighbours(cdt, v).front();
+            int removed = removeScored(cdt, v);
+            if (accept(removed - options.steiner_weight)) {
+                steiner[k] = steiner.back();
+                steiner.pop_back();
+                obtuseCount += removed;
+                METRIC_INC(anneal_accepted);
+                continue;
+            }
+            int restored;
+            steiner[k] = insertScored(cdt, old, anchor->face(), restored);
+            steiner[k]->info().id = id;
+            obtuseCount += removed + restored;
+        }
+    }
+
+    // End in the best state seen, with the Steiner vertices numbered densely in the order of the output
+    trackBest();
+    if (energy() > bestEnergy) {
+        restoreSteinerPoints(cdt, steiner, bestPoints, firstSteinerId);
+        obtuseCount = countObtuseAngles(cdt);
+    }
+    data.steiner_points.clear();
+    for (size_t k = 0; k < steiner.size(); ++k) {
+        steiner[k]->info().id = firstSteinerId + static_cast<int>(k);
+        data.steiner_points.push_back(steiner[k]->point());
+    }
+
+    if (options.verbose) {
+        cout << "Local search: " << obtuseCount << " obtuse angles, " << steiner.size() << " Steiner points" << endl;
+    }
+    if (status) {
+        *status = stopReason;
+    }
+    return obtuseCount;
+}
+
+// Splits the finite faces into k x k tiles of (nearly) equal size: k columns by centroid x,
+// then k rows per column by centroid y. Tiles are sets of whole faces, so seams follow existing edges.
+static vector<vector<CDT::Face_handle>> partitionFaces(const CDT& cdt, unsigned k) {
+    struct Entry {
+        double x, y;
+        CDT::Face_handle face;
+    };
+    vector<Entry> entries;
+    entries.reserve(cdt.number_of_faces());
+    for (auto face = cdt.finite_faces_begin(); face != cdt.finite_faces_end(); ++face) {
+        double x = 0, y = 0;
+        for (int i = 0; i < 3; ++i) {
+            x += CGAL::to_double(face->vertex(i)->point().x());
+            y += CGAL::to_double(face->vertex(i)->point().y());
+        }
+        entries.push_back({x / 3, y / 3, face});
+    }
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.x < b.x; });
+
+    vector<vector<CDT::Face_handle>> tiles;
+    size_t n = entries.size();
+    for (size_t c = 0; c < k; ++c) {
+        auto columnBegin = entries.begin() + c * n / k, columnEnd = entries.begin() + (c + 1) * n / k;
+        sort(columnBegin, columnEnd, [](const Entry& a, const Entry& b) { return a.y < b.y; });
+        size_t m = columnEnd - columnBegin;
+        for (size_t r = 0; r < k; ++r) {
+            vector<CDT::Face_handle> tile;
+            for (auto it = columnBegin + r * m / k; it != columnBegin + (r + 1) * m / k; ++it) {
+                tile.push_back(it->face);
+            }
+            if (!tile.empty()) {
+                tiles.push_back(move(tile));
+            }
+        }
+    }
+    return tiles;
+}
+
+// A copy of p with its own exact coordinates: tiles share no lazy representations with the full CDT
+static Point detachedPoint(const Point& p) {
+    return Point(K::FT(CGAL::exact(p.x())), K::FT(CGAL::exact(p.y())));
+}
+
+// Sub-triangulation of one tile: the vertices of its faces, constrained along the tile outline (the
+// seams) and along the instance constraints inside it. Inside the outline it matches the full CDT;
+// outside it, up to the convex hull, lie filler faces that belong to other tiles. `inside`
+// receives the tile's own faces, the ones the tile's worklist starts from.
+static void buildTile(const vector<CDT::Face_handle>& faces, const set<CDT::Face_handle>& members, CDT& tile,
+                      vector<CDT::Face_handle>& inside) {
+    map<CDT::Vertex_handle, CDT::Vertex_handle> local;
+    CDT::Face_handle hint;
+    auto localVertex = [&](CDT::Vertex_handle v) {
+        auto found = local.find(v);
+        if (found != local.end()) {
+            return found->second;
+        }
+        CDT::Vertex_handle w = tile.insert(detachedPoint(v->point()), hint);
+        hint = w->face();
+        local[v] = w;
+        return w;
+    };
+
+    for (const auto& face : faces) {
+        for (int i = 0; i < 3; ++i) {
+            localVertex(face->vertex(i));
+        }
+    }
+    for (const auto& face : faces) {
+        for (int i = 0; i < 3; ++i) {
+            CDT::Face_handle neighbor = face->neighbor(i);
+            bool seam = members.count(neighbor) == 0;
+            // Edges inside the tile are seen from both faces: constrain them once
+            if (seam || (face->is_constrained(i) && face < neighbor)) {
+                tile.insert_constraint(localVertex(face->vertex(CDT::ccw(i))), localVertex(face->vertex(CDT::cw(i))));
+            }
+        }
+    }
+    tile.invalidate_face_cache();
+
+    inside.clear();
+    for (const auto& face : faces) {
+        CDT::Face_handle own;
+        if (tile.is_face(local[face->vertex(0)], local[face->vertex(1)], local[face->vertex(2)], own)) {
+            inside.push_back(own);
+        }
+    }
+}
+
+int improveTiled(CDT& cdt, TriangulationData& data, const SolverOptions& options, string* status) {
+    auto start = chrono::steady_clock::now();
+    vector<vector<CDT::Face_handle>> tileFaces = partitionFaces(cdt, max(1u, options.tiles));
+    vector<set<CDT::Face_handle>> members(tileFaces.size());
+    vector<unique_ptr<CDT>> tiles(tileFaces.size());
+    vector<vector<CDT::Face_handle>> tileSeeds(tileFaces.size());
+    for (size_t t = 0; t < tileFaces.size(); ++t) {
+        members[t].insert(tileFaces[t].begin(), tileFaces[t].end());
+        tiles[t].reset(new CDT());
+        buildTile(tileFaces[t], members[t], *tiles[t], tileSeeds[t]);
+    }
+
+    // One single-threaded improvement loop per tile, tiles spread over the workers.
+    // Most of the time limit goes to the tiles, the rest to merging and the seam pass. The tiles
+    // share one deadline: with more tiles than workers, a tile that starts late gets what is left
+    // of it, and a tile that would start after it is skipped.
+    SolverOptions tileOptions = options;
+    tileOptions.threads = 1;
+    tileOptions.verbose = false;
+    tileOptions.checkpoint = nullptr; // a tile is not a solution
+    auto tileDeadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(0.8 * options.time_limit));
+    vector<vector<Point>> tileSteiner(tiles.size());
+    WorkerPool pool(max(1u, options.threads));
+    Metrics* metrics = METRIC_CURRENT();
+    pool.run(tiles.size(), [&](size_t t) {
+        METRIC_SCOPE(metrics);
+        SolverOptions ownOptions = tileOptions;
+        if (options.time_limit > 0) {
+            ownOptions.time_limit = chrono::duration<double>(tileDeadline - chrono::steady_clock::now()).count();
+            if (ownOptions.time_limit <= 0) {
+                tileSeeds[t].clear();
+                tiles[t].reset();
+                return;
+            }
+        }
+        // Only the faces inside the outline: the filler's points would be thrown away below
+        TriangulationData tileData;
+        improveTriangulation(*tiles[t], tileData, ownOptions, nullptr, &tileSeeds[t]);
+        tileSteiner[t] = move(tileData.steiner_points);
+        tileSeeds[t].clear();
+        tiles[t].reset();
+    });
+
+    // Keep the points each tile placed in its own faces, not in the filler around its outline.
+    // All of them are located before any is inserted, while the tile faces still exist.
+    vector<Point> kept;
+    CDT::Face_handle hint;
+    for (size_t t = 0; t < tileSteiner.size(); ++t) {
+        for (const auto& p : tileSteiner[t]) {
+            CDT::Locate_type lt;
+            int li;
+            CDT::Face_handle face = cdt.locate(p, lt, li, hint);
+            bool inside = (lt == CDT::FACE && members[t].count(face)) ||
+                          (lt == CDT::EDGE && (members[t].count(face) || members[t].count(face->neighbor(li))));
+            if (inside) {
+                kept.push_back(p);
+                hint = face;
+            }
+        }
+    }
+    members.clear();
+
+    // Merge: the kept points go into the full triangulation, numbered after its vertices. A tile
+    // measured its gains with its outline constrained; here the seams can flip, so every merged
+    // point is scored again and kept only if it still reduces the obtuse angles.
+    int nextVertexId = 0;
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        nextVertexId = max(nextVertexId, vertex->info().id + 1);
+    }
+    // Hints come from the last merged vertex: a rollback may rebuild the faces around it
+    CDT::Vertex_handle last;
+    size_t merged = 0;
+    for (const auto& p : kept) {
+        cdt.checkpoint();
+        CDT::Vertex_handle v = cdt.tentative_insert(p, last != CDT::Vertex_handle() ? last->face() : CDT::Face_handle());
+        METRIC_INC(tentative_inserts);
+        if (cdt.last_insert().lt == CDT::VERTEX) {
+            cdt.rollback(); // two tiles put a point on the same seam vertex
+            continue;
+        }
+        if (insertionObtuseDelta(cdt, cdt.last_insert()) >= 0) {
+            cdt.rollback();
+            METRIC_INC(rollbacks);
+            continue;
+        }
+        cdt.commit();
+        v->info().id = nextVertexId++;
+        compactPoint(v->point());
+        data.steiner_points.push_back(p);
+        last = v;
+        ++merged;
+    }
+    if (options.verbose) {
+        cout << "Tiled solving: " << tileFaces.size() << " tiles, " << merged << " of " << kept.size() << " Steiner points merged, "
+             << countObtuseAngles(cdt) << " obtuse angles before the seam pass" << endl;
+    }
+
+    // Seam pass: the greedy loop over what the tiles left, mostly faces along the seams
+    SolverOptions seamOptions = options;
+    if (options.time_limit > 0) {
+        seamOptions.time_limit = max(1e-3, options.time_limit - chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    return improveTriangulation(cdt, data, seamOptions, status);
+}
+
+// Steiner improvement and the optional annealing, on a constructed CDT; what is left of the budget
+// is measured from `start`
+static void improvePhases(CDT& cdt, TriangulationData& data, const SolverOptions& options,
+                          chrono::steady_clock::time_point start, SolveResult& result) {
+    // The time limit covers the whole instance, construction included, and leaves time to write it
+    const double solveLimit = options.time_limit * (1 - min(max(options.write_reserve, 0.0), 0.5));
+    auto remaining = [&] {
+        return max(1e-3, solveLimit - chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    };
+    SolverOptions improveOptions = options;
+    if (options.time_limit > 0) {
+        improveOptions.time_limit = remaining();
+    }
+
+    // Greedy Steiner point insertion, candidates evaluated on `options.threads` threads
+    {
+        METRIC_PHASE(PHASE_IMPROVE);
+        if (options.tiles > 1) {
+            result.final_obtuse = improveTiled(cdt, data, improveOptions, &result.status);
+        } else {
+            result.final_obtuse = improveTriangulation(cdt, data, improveOptions, &result.status);
+        }
+    }
+
+    // Optional local search from the greedy result, then a greedy polish of what it leaves
+    if (options.anneal_steps > 0 && result.status == "converged") {
+        METRIC_PHASE(PHASE_ANNEAL);
+        SolverOptions annealOptions = options;
+        if (options.time_limit > 0) {
+            annealOptions.time_limit = remaining();
+        }
+        annealTriangulation(cdt, data, annealOptions, &result.status);
+        if (options.time_limit > 0) {
+            annealOptions.time_limit = remaining();
+        }
+        result.final_obtuse = improveTriangulation(cdt, data, annealOptions, &result.status);
+    }
+    result.steiner_points = data.steiner_points.size();
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+SolveResult solveInstance(const InputData& instance_data, const SolverOptions& options, CDT& cdt, TriangulationData& data) {
+    auto start = chrono::steady_clock::now();
+    SolveResult result;
+    result.instance_uid = instance_data.getInstanceUid();
+
+    //////////////////// Insert Instance ////////////////////
+    {
+        METRIC_PHASE(PHASE_BUILD);
+        buildTriangulation(instance_data, cdt);
+    }
+
+    //check how many obtuse angles are in the initial polygon
+    result.initial_obtuse = countObtuseAngles(cdt);
+    if (options.verbose) {
+        cout << "Initial number of obtuse angles: " << result.initial_obtuse << endl;
+    }
+
+    //////////////////// Improve CDT using Edge Flips ////////////////////
+    {
+        METRIC_PHASE(PHASE_FLIPS);
+        performEdgeFlips(cdt, options.obtuse_flips ? shouldFlipObtuse : shouldFlip);
+    }
+    if (options.verbose) {
+        cout << "Number of obtuse angles after Edge Flips: " << countObtuseAngles(cdt) << endl;
+    }
+
+    improvePhases(cdt, data, options, start, result);
+    return result;
+}
+
+SolveResult resumeInstance(const string& instance_uid, int input_points, const SolverOptions& options, CDT& cdt, TriangulationData& data) {
+    auto start = chrono::steady_clock::now();
+    SolveResult result;
+    result.instance_uid = instance_uid;
+
+    // The Steiner points so far, in id order, so new ones keep being numbered after them
+    vector<pair<int, Point>> steiner;
+    for (auto vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex) {
+        if (vertex->info().id >= input_points) {
+            steiner.push_back({vertex->info().id, vertex->point()});
+        }
+    }
+    sort(steiner.begin(), steiner.end(), [](const pair<int, Point>& a, const pair<int, Point>& b) {
+        return a.first < b.first;
+    });
+    data.steiner_points.clear();
+    for (const auto& entry : steiner) {
+        data.steiner_points.push_back(entry.second);
+    }
+
+    result.initial_obtuse = countObtuseAngles(cdt);
+    if (options.verbose) {
+        cout << "Resumed with " << data.steiner_points.size() << " Steiner points and "
+             << result.initial_obtuse << " obtuse angles" << endl;
+    }
+
+    improvePhases(cdt, data, options, start, result);
+    return result;
+}
+
+// RFC 4180 field: quoted, with embedded quotes doubled
+static string csvField(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+int runBatch(const vector<string>& inputs, const string& output_dir, const SolverOptions& options, unsigned jobs) {
+    namespace fs = std::filesystem;
+    fs::create_directories(output_dir);
+
+    // Parallelism is across instances; each solve stays quiet and single-threaded unless asked otherwise
+    SolverOptions instanceOptions = options;
+    instanceOptions.verbose = false;
+
+    vector<SolveResult> results(inputs.size());
+    atomic<size_t> next{0};
+    mutex logMutex;
+
+    auto worker = [&] {
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            SolveResult& result = results[i];
+            if (stopRequested()) {
+                result.instance = inputs[i];
+                result.status = "interrupted";
+                continue;
+            }
+            auto start = chrono::steady_clock::now();
+            string name = fs::path(inputs[i]).stem().string();
+            try {
+                Metrics metrics;
+                METRIC_SCOPE(&metrics);
+                InputData instance_data;
+                {
+                    METRIC_PHASE(PHASE_READ);
+                    instance_data = readJsonFile(inputs[i]);
+                }
+                if (instance_data.getPointsX().empty()) {
+                    throw runtime_error("no points read");
+                }
+                CDT cdt;
+                TriangulationData data;
+                string output = (fs::path(output_dir) / (name + ".solution.json")).string();
+                // The time limit covers reading too; checkpoints replace the solution file atomically
+                SolverOptions solveOptions = instanceOptions;
+                if (solveOptions.time_limit > 0) {
+                    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    solveOptions.time_limit = max(1e-3, solveOptions.time_limit - elapsed);
+                }
+                string uid = instance_data.getInstanceUid();
+                solveOptions.checkpoint = [&output, uid](const CDT& best, const TriangulationData& bestData) {
+                    writeJsonOutput(output, uid, bestData.steiner_points, best);
+                };
+                result = solveInstance(instance_data, solveOptions, cdt, data);
+                {
+                    METRIC_PHASE(PHASE_WRITE);
+                    writeJsonOutput(output, result.instance_uid, data.steiner_points, cdt);
+                }
+                if (metricsEnabled()) {
+                    writeMetricsJson(metricsPathFor(output), result.instance_uid, metrics, strategyNames());
+                }
+            } catch (const exception& e) {
+                result.status = "error";
+                result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                lock_guard<mutex> lock(logMutex);
+                cerr << "Error solving " << inputs[i] << ": " << e.what() << endl;
+            }
+            result.instance = inputs[i];
+
+            lock_guard<mutex> lock(logMutex);
+            cout << "[" << (i + 1) << "/" << inputs.size() << "] " << name << ": " << result.status
+                 << ", obtuse " << result.initial_obtuse << " -> " << result.final_obtuse
+                 << ", steiner " << result.steiner_points << ", " << result.seconds << "s" << endl;
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned j = 1; j < max(1u, jobs); ++j) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    // Summary table, in input order
+    string summary = (fs::path(output_dir) / "summary.csv").string();
+    ofstream table(summary);
+    table << "instance,instance_uid,status,initial_obtuse,final_obtuse,steiner_points,wall_seconds\n";
+    int failed = 0;
+    for (const auto& result : results) {
+        table << csvField(result.instance) << "," << csvField(result.instance_uid) << "," << result.status << ","
+              << result.initial_obtuse << "," << result.final_obtuse << "," << result.steiner_points << ","
+              << fixed << setprecision(3) << result.seconds << "\n";
+        if (result.status == "error") {
+            ++failed;
+        }
+    }
+    cout << "Summary written to " << summary << endl;
+
+    return failed;
+}
@@ -0,0 +1,137 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include "utils.hpp"
+#include "metrics.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Receives the best solution found so far, e.g. to write it to the solution file
+typedef function<void(const CDT& cdt, const TriangulationData& data)> CheckpointWriter;
+
+struct SolverOptions {
+    unsigned threads = 1;    // worker threads for candidate evaluation (including the caller)
+    size_t batch_size = 64;  // obtuse faces evaluated per parallel round
+    unsigned tiles = 0;      // tiled solving on a tiles x tiles partition of the faces, 0/1 = off
+    bool inexact_constructions = false; // search with InexactConstructions, rebuild winners exactly
+    bool prescreen = true;   // settle candidates in interval arithmetic first, exact constructions only for promising or uncertain ones
+    bool adaptive_strategies = false; // per face, try strategies in order of success on this instance, stop at the first improving one
+    double strategy_skip = 0; // leave out strategies whose optimistic success rate is below this, 0 = never
+    int snap_bits = 0;       // round Steiner points to multiples of 2^-snap_bits when that keeps the gain, 0 = exact
+    bool obtuse_flips = false; // flip edges to reduce obtuse angles (initially and around each Steiner point) instead of only Delaunay flips
+    bool verbose = true;     // log every improvement to cout
+    double time_limit = 0;   // seconds per instance, 0 = unlimited
+    double write_reserve = 0.05; // share of time_limit left for writing the solution
+    double checkpoint_interval = 0; // seconds between checkpoints, 0 = none
+    CheckpointWriter checkpoint;    // called with the best solution so far at every checkpoint
+    size_t memory_limit_mb = 0; // estimated triangulation size per instance, 0 = unlimited
+    size_t rss_limit_mb = 0; // resident set ceiling of the whole process, 0 = unlimited
+    size_t anneal_steps = 0; // local-search moves after the greedy loop, 0 = off
+    double anneal_t0 = 2.0;  // start temperature, in energy units (one obtuse angle = 1)
+    double anneal_t1 = 0.05; // end temperature, reached geometrically
+    double steiner_weight = 0.25; // energy = obtuse angles + steiner_weight * Steiner points
+    uint64_t seed = 1;       // random moves of the local search
+};
+
+// Outcome of one instance, one row of the batch summary
+struct SolveResult {
+    string instance;         // input file
+    string instance_uid;
+    string status;           // converged, time_limit, memory_limit, interrupted or error
+    int initial_obtuse = 0;  // after constructing the CDT
+    int final_obtuse = 0;
+    size_t steiner_points = 0;
+    double seconds = 0;      // wall time
+};
+
+// Fixed set of threads that run an indexed task in parallel; the calling thread takes part too
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    // Runs task(i) for every i in [0, count) and returns once all of them have finished
+    void run(size_t count, const function<void(size_t)>& task);
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+private:
+    void workerLoop();
+    void drain();
+
+    vector<thread> workers_;
+    mutex mutex_;
+    condition_variable wake_;
+    condition_variable done_;
+    const function<void(size_t)>* task_ = nullptr;
+    size_t count_ = 0;
+    atomic<size_t> next_{0};
+    size_t active_ = 0;
+    unsigned generation_ = 0;
+    bool stop_ = false;
+};
+
+// Greedy Steiner improvement loop. Each round takes a batch of obtuse faces from the worklist,
+// scores every (face, strategy) candidate in parallel against the unchanged triangulation, then a
+// single committer applies the best candidate of each face unless an earlier commit of the same
+// round touched its conflict region. Results only depend on the batch size, not the thread count.
+// With inexact constructions the winner is rebuilt with ExactConstructions and validated by an
+// exact tentative insertion, so every committed Steiner point is an exact construction.
+// Stops early at options.time_limit / options.memory_limit_mb / options.rss_limit_mb or on
+// requestStop() and reports why in `status`. Only improvements are committed, so the state at any point is the best one so far;
+// it is passed to options.checkpoint every options.checkpoint_interval seconds.
+// The worklist starts with every obtuse face, or only with the obtuse ones of `seedFaces`.
+// Returns the final number of obtuse angles.
+int improveTriangulation(CDT& cdt, TriangulationData& data, const SolverOptions& options, string* status = nullptr,
+                         const vector<CDT::Face_handle>* seedFaces = nullptr);
+
+// Tiled variant of improveTriangulation for very large instances. The faces are split into
+// options.tiles x options.tiles tiles of equal size; each tile becomes its own sub-triangulation,
+// constrained along its outline, and is improved by a single-threaded loop, the tiles spread over
+// options.threads workers. The Steiner points each tile placed inside its outline are reinserted
+// into cdt, then a greedy pass over the whole triangulation repairs the faces along the seams.
+int improveTiled(CDT& cdt, TriangulationData& data, const SolverOptions& options, string* status = nullptr);
+
+// Simulated annealing over Steiner moves, for the obtuse faces the greedy loop leaves behind:
+// insert a strategy point into an obtuse face, relocate a Steiner vertex into a face of its star,
+// or remove a Steiner vertex. Minimizes obtuse angles + steiner_weight * Steiner points; each move
+// is scored over the faces it changes only and accepted by the Metropolis rule at a temperature
+// falling geometrically from anneal_t0 to anneal_t1 over anneal_steps moves.
+// Steiner vertices on constrained edges stay in place. Stops at options.time_limit,
+// options.rss_limit_mb or on requestStop(). Ends in the lowest-energy state seen, which
+// is also what checkpoints receive; data.steiner_points is rebuilt at the end.
+// Returns the final number of obtuse angles.
+int annealTriangulation(CDT& cdt, TriangulationData& data, const SolverOptions& options, string* status = nullptr);
+
+// The full pipeline for one instance: CDT construction, edge flips, Steiner improvement.
+// options.time_limit covers all of it, less options.write_reserve of it kept for the caller's write.
+SolveResult solveInstance(const InputData& instance_data, const SolverOptions& options, CDT& cdt, TriangulationData& data);
+
+// Continues a solve from an already built CDT, e.g. one loaded from a snapshot: vertices with
+// id >= input_points are taken as the Steiner points so far, then the improvement phases run as
+// in solveInstance. options.time_limit counts from the call.
+SolveResult resumeInstance(const string& instance_uid, int input_points, const SolverOptions& options, CDT& cdt, TriangulationData& data);
+
+// Asks every running solve to stop at its next check and return its best solution.
+// Only sets an atomic flag, so it may be called from a signal handler.
+void requestStop();
+bool stopRequested();
+
+// Names of the Steiner strategies, in the order of the per-strategy metrics
+vector<string> strategyNames();
+
+// Solves every input on `jobs` threads (one instance per thread, never opening the viewer),
+// writes <output_dir>/<name>.solution.json (and its metrics sidecar) per instance and <output_dir>/summary.csv.
+// Returns the number of instances that failed.
+int runBatch(const vector<string>& inputs, const string& output_dir, const SolverOptions& options, unsigned jobs);
+
+#endif // SOLVER_HPP
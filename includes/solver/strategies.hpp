@@ -0,0 +1,81 @@
+#ifndef STRATEGIES_HPP
+#define STRATEGIES_HPP
+
+#include "utils.hpp"
+
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+// Steiner strategies, registered at compile time. A strategy is a type with a static `name`
+// and a static compute<KernelPolicy>(face, cdt, steiner) that fills a SteinerCandidate (and
+// its location, when known) or returns false when it has no point for the face.
+// StrategyRegistry dispatches on the strategy index with an inlined comparison chain:
+// no function pointers, no virtual calls.
+// To add a strategy, define its type here and append it to SteinerStrategies; the solver,
+// the metrics and the benchmark all take the list from there.
+
+struct CircumcenterCentroidStrategy {
+    static constexpr const char* name = "Circumcenter/Centroid";
+    template <class KernelPolicy>
+    static bool compute(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner) {
+        return steinerCircumcenterCentroid<KernelPolicy>(face, cdt, steiner);
+    }
+};
+
+struct MedianStrategy {
+    static constexpr const char* name = "Median";
+    template <class KernelPolicy>
+    static bool compute(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner) {
+        return steinerMedian<KernelPolicy>(face, cdt, steiner);
+    }
+};
+
+struct ProjectionStrategy {
+    static constexpr const char* name = "Projection";
+    template <class KernelPolicy>
+    static bool compute(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner) {
+        return steinerProjection<KernelPolicy>(face, cdt, steiner);
+    }
+};
+
+struct CentroidPolygonStrategy {
+    static constexpr const char* name = "CentroidPolygon";
+    template <class KernelPolicy>
+    static bool compute(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner) {
+        return centroidPolygon<KernelPolicy>(face, cdt, steiner);
+    }
+};
+
+template <class... Strategies>
+struct StrategyRegistry {
+    static constexpr size_t size = sizeof...(Strategies);
+
+    static const char* name(size_t index) {
+        static const char* const names[] = {Strategies::name...};
+        return names[index];
+    }
+
+    // Runs strategy `index`; false if it has no point for the face (or the index is out of range).
+    // The candidate comes back tagged with the strategy, and located if the strategy knows where its point lies.
+    template <class KernelPolicy>
+    static bool compute(size_t index, CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner) {
+        steiner.face = CDT::Face_handle();
+        steiner.strategy = index;
+        return dispatch<KernelPolicy>(index, face, cdt, steiner, index_sequence_for<Strategies...>());
+    }
+
+private:
+    template <class KernelPolicy, size_t... I>
+    static bool dispatch(size_t index, CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner, index_sequence<I...>) {
+        bool found = false;
+        (void)((index == I && ((found = Strategies::template compute<KernelPolicy>(face, cdt, steiner)), true)) || ...);
+        return found;
+    }
+};
+
+// In the order they were always tried: on equal gains the earlier strategy wins
+typedef StrategyRegistry<CircumcenterCentroidStrategy, MedianStrategy, ProjectionStrategy, CentroidPolygonStrategy> SteinerStrategies;
+
+#endif // STRATEGIES_HPP
@@ -0,0 +1,213 @@
+#include "json_reader.hpp"
+
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+JsonReader::JsonReader(const string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw JsonError("cannot open " + filename, 0);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            mapping_ = mapping;
+            mapped_size_ = static_cast<size_t>(info.st_size);
+            begin_ = static_cast<const char*>(mapping);
+        }
+    }
+    ::close(fd);
+
+    // Pipes, empty or unmappable files
+    if (!mapping_) {
+        ifstream file(filename, ios::binary);
+        buffer_.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        begin_ = buffer_.data();
+        mapped_size_ = buffer_.size();
+    }
+    pos_ = begin_;
+    end_ = begin_ + mapped_size_;
+}
+
+JsonReader::~JsonReader() {
+    if (mapping_) {
+        ::munmap(mapping_, mapped_size_);
+    }
+}
+
+void JsonReader::fail(const string& message) const {
+    throw JsonError(message, offset());
+}
+
+void JsonReader::skipWhitespace() {
+    while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+        ++pos_;
+    }
+}
+
+bool JsonReader::atEnd() {
+    skipWhitespace();
+    return pos_ == end_;
+}
+
+bool JsonReader::consume(char c) {
+    skipWhitespace();
+    if (pos_ < end_ && *pos_ == c) {
+        ++pos_;
+        return true;
+    }
+    return false;
+}
+
+char JsonReader::peek() {
+    skipWhitespace();
+    return pos_ < end_ ? *pos_ : '\0';
+}
+
+void JsonReader::expect(char c) {
+    if (!consume(c)) {
+        fail(pos_ < end_ ? string("expected '") + c + "', found '" + *pos_ + "'" : string("expected '") + c + "', found end of file");
+    }
+}
+
+static void appendUtf8(string& out, unsigned code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+string JsonReader::readString() {
+    expect('"');
+    string out;
+    while (true) {
+        if (pos_ == end_) {
+            fail("unterminated string");
+        }
+        char c = *pos_++;
+        if (c == '"') {
+            return out;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (pos_ == end_) {
+            fail("unterminated escape");
+        }
+        char e = *pos_++;
+        switch (e) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                for (int i = 0; i < 4; ++i) {
+                    if (pos_ == end_ || !isxdigit(static_cast<unsigned char>(*pos_))) {
+                        fail("invalid \\u escape");
+                    }
+                    char h = *pos_++;
+                    code = code * 16 + (isdigit(static_cast<unsigned char>(h)) ? h - '0' : (tolower(h) - 'a' + 10));
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                --pos_;
+                fail(string("invalid escape '\\") + e + "'");
+        }
+    }
+}
+
+long long JsonReader::readInteger() {
+    skipWhitespace();
+    const char* start = pos_;
+    bool negative = false;
+    if (pos_ < end_ && *pos_ == '-') {
+        negative = true;
+        ++pos_;
+    }
+    if (pos_ == end_ || !isdigit(static_cast<unsigned char>(*pos_))) {
+        pos_ = start;
+        fail("expected an integer");
+    }
+    unsigned long long value = 0;
+    while (pos_ < end_ && isdigit(static_cast<unsigned char>(*pos_))) {
+        unsigned digit = static_cast<unsigned>(*pos_ - '0');
+        // Checked before the multiply, which could otherwise wrap past the limit
+        if (value > (static_cast<unsigned long long>(LLONG_MAX) - digit) / 10) {
+            pos_ = start;
+            fail("integer out of range");
+        }
+        value = value * 10 + digit;
+        ++pos_;
+    }
+    if (pos_ < end_ && (*pos_ == '.' || *pos_ == 'e' || *pos_ == 'E')) {
+        fail("expected an integer, found a fractional number");
+    }
+    return negative ? -static_cast<long long>(value) : static_cast<long long>(value);
+}
+
+int JsonReader::readInt() {
+    size_t start = offset();
+    long long value = readInteger();
+    if (value < INT_MIN || value > INT_MAX) {
+        throw JsonError("integer out of range", start);
+    }
+    return static_cast<int>(value);
+}
+
+void JsonReader::readIntArray(vector<int>& out) {
+    readArray([&] { out.push_back(readInt()); });
+}
+
+void JsonReader::skipValue() {
+    skipWhitespace();
+    if (pos_ == end_) {
+        fail("expected a value, found end of file");
+    }
+    switch (*pos_) {
+        case '{':
+            readObject([&](const string&) { skipValue(); });
+            return;
+        case '[':
+            readArray([&] { skipValue(); });
+            return;
+        case '"':
+            readString();
+            return;
+        default:
+            break;
+    }
+    // Numbers and literals
+    const char* start = pos_;
+    while (pos_ < end_ && (isalnum(static_cast<unsigned char>(*pos_)) || *pos_ == '-' || *pos_ == '+' || *pos_ == '.')) {
+        ++pos_;
+    }
+    if (pos_ == start) {
+        fail(string("unexpected character '") + *pos_ + "'");
+    }
+}
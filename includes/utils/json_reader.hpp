@@ -0,0 +1,85 @@
+#ifndef JSON_READER_HPP
+#define JSON_READER_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Parse error with the byte offset where it was detected
+struct JsonError : public runtime_error {
+    size_t offset;
+    JsonError(const string& message, size_t offset)
+        : runtime_error(message + " at byte " + to_string(offset)), offset(offset) {}
+};
+
+// Single-pass pull reader over a memory-mapped JSON file (read into memory if mapping fails).
+// The caller walks the document it expects; nothing is materialized besides what it keeps.
+class JsonReader {
+public:
+    explicit JsonReader(const string& filename);
+    ~JsonReader();
+
+    JsonReader(const JsonReader&) = delete;
+    JsonReader& operator=(const JsonReader&) = delete;
+
+    // Skips whitespace; consumes `c` and returns true if it is next
+    bool consume(char c);
+    // Skips whitespace; the next character without consuming it, '\0' at the end
+    char peek();
+    void expect(char c);
+
+    string readString();
+    long long readInteger();
+    int readInt();
+    void skipValue();
+
+    // Calls element() once per array item, the cursor placed on the item
+    template <class Element>
+    void readArray(Element&& element) {
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            element();
+        } while (consume(','));
+        expect(']');
+    }
+
+    // Calls member(key) once per object member, the cursor placed on its value
+    template <class Member>
+    void readObject(Member&& member) {
+        expect('{');
+        if (consume('}')) {
+            return;
+        }
+        do {
+            string key = readString();
+            expect(':');
+            member(key);
+        } while (consume(','));
+        expect('}');
+    }
+
+    // Appends every integer of a flat array to `out`
+    void readIntArray(vector<int>& out);
+
+    bool atEnd();
+    size_t offset() const { return static_cast<size_t>(pos_ - begin_); }
+    [[noreturn]] void fail(const string& message) const;
+
+private:
+    void skipWhitespace();
+
+    const char* begin_ = nullptr;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    void* mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    vector<char> buffer_;
+};
+
+#endif // JSON_READER_HPP
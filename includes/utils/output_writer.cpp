@@ -0,0 +1,136 @@
+#include "output_writer.hpp"
+
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+BufferedWriter::BufferedWriter(const string& filename, bool atomic_replace, size_t buffer_size)
+    : filename_(filename), buffer_(buffer_size) {
+    if (atomic_replace) {
+        temp_filename_ = filename + ".tmp";
+    }
+    fd_ = ::open((atomic_replace ? temp_filename_ : filename).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    failed_ = fd_ < 0;
+}
+
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+void BufferedWriter::flush() {
+    const char* data = buffer_.data();
+    size_t left = used_;
+    while (left > 0 && fd_ >= 0) {
+        ssize_t written = ::write(fd_, data, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed_ = true;
+            break;
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+    used_ = 0;
+}
+
+void BufferedWriter::write(const char* data, size_t size) {
+    if (size > buffer_.size() - used_) {
+        flush();
+        // Larger than the whole buffer: hand it to the kernel directly
+        if (size >= buffer_.size()) {
+            while (size > 0 && fd_ >= 0) {
+                ssize_t written = ::write(fd_, data, size);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    failed_ = true;
+                    return;
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return;
+        }
+    }
+    memcpy(buffer_.data() + used_, data, size);
+    used_ += size;
+}
+
+void BufferedWriter::writeInt(long long value) {
+    char digits[24];
+    auto result = to_chars(digits, digits + sizeof(digits), value);
+    write(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\r': quoted += "\\r"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    quoted += escaped;
+                } else {
+                    quoted += c;
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+void BufferedWriter::writeJsonString(const string& text) {
+    write(jsonString(text));
+}
+
+void BufferedWriter::writeU32(uint32_t value) {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    write(bytes, 4);
+}
+
+void BufferedWriter::writeU64(uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    write(bytes, 8);
+}
+
+bool BufferedWriter::close() {
+    if (fd_ < 0) {
+        return !failed_;
+    }
+    flush();
+    // The data must be on disk before the rename makes it visible under the final name
+    if (!temp_filename_.empty() && ::fsync(fd_) != 0) {
+        failed_ = true;
+    }
+    if (::close(fd_) != 0) {
+        failed_ = true;
+    }
+    fd_ = -1;
+    if (!temp_filename_.empty()) {
+        if (failed_ || ::rename(temp_filename_.c_str(), filename_.c_str()) != 0) {
+            failed_ = true;
+            ::unlink(temp_filename_.c_str());
+        }
+    }
+    return !failed_;
+}
@@ -0,0 +1,57 @@
+#ifndef OUTPUT_WRITER_HPP
+#define OUTPUT_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// JSON string literal: quoted, with quotes, backslashes and control characters escaped
+string jsonString(const string& text);
+
+// Buffered writer on a raw file descriptor: output goes out in large write(2) calls,
+// without iostream formatting or an intermediate document.
+// With `atomic_replace` the data goes to <filename>.tmp, which close() renames over filename
+// only if every write succeeded: readers see the old file or the complete new one, never a torn one.
+class BufferedWriter {
+public:
+    explicit BufferedWriter(const string& filename, bool atomic_replace = false, size_t buffer_size = 1 << 20);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+    bool failed() const { return failed_; }
+
+    void write(const char* data, size_t size);
+    void write(const string& text) { write(text.data(), text.size()); }
+    void put(char c) {
+        if (used_ == buffer_.size()) {
+            flush();
+        }
+        buffer_[used_++] = c;
+    }
+    void writeInt(long long value);
+    // JSON string literal, quoted and escaped
+    void writeJsonString(const string& text);
+    // Little-endian binary fields
+    void writeU32(uint32_t value);
+    void writeU64(uint64_t value);
+
+    void flush();
+    // Flushes and closes (and renames, in atomic mode); returns false if any write failed
+    bool close();
+
+private:
+    string filename_;
+    string temp_filename_; // empty unless atomic_replace
+    int fd_ = -1;
+    vector<char> buffer_;
+    size_t used_ = 0;
+    bool failed_ = false;
+};
+
+#endif // OUTPUT_WRITER_HPP
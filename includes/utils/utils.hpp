@@ -2,7 +2,14 @@
 #define UTILS_HPP
 
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Simple_cartesian.h>
+#include <CGAL/Interval_nt.h>
 //#include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
+#include <CGAL/Constrained_triangulation_face_base_2.h>
+#include <CGAL/Triangulation_data_structure_2.h>
 #include "custom.hpp"
 #include <string>
 #include <vector>
@@ -10,6 +17,9 @@
 #include <CGAL/Polygon_2.h>
 #include <stack>
 #include <set>
+#include <deque>
+#include <array>
+#include <atomic>
 #include <CGAL/centroid.h>
 #include <regex>
 
@@ -18,13 +28,69 @@ using namespace std;
 // Define the Kernel and CDT type
 typedef CGAL::Exact_predicates_exact_constructions_kernel K;
 typedef CGAL::Exact_predicates_tag Itag;
-typedef Custom_Constrained_Delaunay_triangulation_2<K, CGAL::Default, Itag> CDT;
+// Each vertex carries its output index: input points 0..n-1, then Steiner points in insertion order.
+// Vertices created implicitly (e.g. at constraint intersections) keep id -1 until output.
+struct VertexInfo {
+    int id = -1;
+};
+// Per-face cache, reset by the CDT whenever the face changes (see custom.hpp).
+// `obtuse` is filled lazily, possibly by several evaluation threads at once, hence atomic:
+// unknown, -1 for no obtuse angle, or the index of the obtuse vertex.
+// `visit` holds one traversal stamp per lane (see FaceVisitor).
+struct FaceInfo {
+    static const signed char unknown = -2;
+    std::atomic<signed char> obtuse{unknown};
+    std::array<unsigned short, custom_visit_lanes> visit{};
+
+    FaceInfo() = default;
+    FaceInfo(const FaceInfo& other) : obtuse(other.obtuse.load(std::memory_order_relaxed)), visit(other.visit) {}
+    FaceInfo& operator=(const FaceInfo& other) {
+        obtuse.store(other.obtuse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        visit = other.visit;
+        return *this;
+    }
+    void invalidate() { obtuse.store(unknown, std::memory_order_relaxed); }
+};
+typedef CGAL::Triangulation_vertex_base_with_info_2<VertexInfo, K> Vb;
+typedef CGAL::Triangulation_face_base_with_info_2<FaceInfo, K> Fbb;
+typedef CGAL::Constrained_triangulation_face_base_2<K, Fbb> Fb;
+typedef CGAL::Triangulation_data_structure_2<Vb, Fb> Tds;
+typedef Custom_Constrained_Delaunay_triangulation_2<K, Tds, Itag> CDT;
 typedef CDT::Point Point;
 
 typedef CDT::Triangle Triangle;
 typedef K::Line_2 Line_2;
 typedef CGAL::Polygon_2<K> Polygon_2;
 
+// Kernel policies for the Steiner constructions of the search phase. The triangulation itself
+// always uses the exact kernel K; a policy only decides in which kernel candidates are built
+// (Kernel) and what a strategy hands back (Candidate, converted by toCandidate).
+struct ExactConstructions {
+    typedef K Kernel;
+    typedef Point Candidate;
+    static const Point& toSearch(const Point& p) { return p; }
+    static const Point& toCandidate(const Point& p) { return p; }
+};
+
+// Double constructions: no lazy-exact DAGs. The candidate is rounded to a double point,
+// which converts back to K exactly; winners are rebuilt with ExactConstructions before commit.
+struct InexactConstructions {
+    typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
+    typedef Point Candidate;
+    static Kernel::Point_2 toSearch(const Point& p) { return Kernel::Point_2(CGAL::to_double(p.x()), CGAL::to_double(p.y())); }
+    static Point toCandidate(const Kernel::Point_2& p) { return Point(p.x(), p.y()); }
+};
+
+// Interval constructions for the pre-screen: the candidate is a box of doubles that is
+// guaranteed to contain the exact candidate. Comparisons the box cannot settle throw
+// CGAL::Uncertain_conversion_exception; needs CGAL::Protect_FPU_rounding<true> around it.
+struct IntervalConstructions {
+    typedef CGAL::Simple_cartesian<CGAL::Interval_nt<false>> Kernel;
+    typedef Kernel::Point_2 Candidate;
+    static Kernel::Point_2 toSearch(const Point& p) { return CGAL::approx(p); }
+    static const Kernel::Point_2& toCandidate(const Kernel::Point_2& p) { return p; }
+};
+
 struct TriangulationData {
     vector<Point> steiner_points;
     vector<pair<Point, Point>> edges;
@@ -33,11 +99,11 @@ struct TriangulationData {
 class InputData {
 private:
     string instance_uid_;
-    int num_points_;
+    int num_points_ = 0;
     vector<int> points_x_;
     vector<int> points_y_;
     vector<int> region_boundary_;
-    int num_constraints_;
+    int num_constraints_ = 0;
     vector<vector<int>> additional_constraints_;
 public:
     // Setters
@@ -49,6 +115,12 @@ public:
     void setNumConstraints(int num_constraints) { num_constraints_ = num_constraints; }
     void setAdditionalConstraints(const vector<vector<int>>& constraints) { additional_constraints_ = constraints; }
 
+    // Moving setters, so a reader can hand over its arrays without copying them
+    void setPointsX(vector<int>&& points_x) { points_x_ = move(points_x); }
+    void setPointsY(vector<int>&& points_y) { points_y_ = move(points_y); }
+    void setRegionBoundary(vector<int>&& region_boundary) { region_boundary_ = move(region_boundary); }
+    void setAdditionalConstraints(vector<vector<int>>&& constraints) { additional_constraints_ = move(constraints); }
+
     // Getters
     string getInstanceUid() const { return instance_uid_; }
     int getNumPoints() const { return num_points_; }
@@ -95,23 +167,164 @@ public:
 
 // Declaration of additional utility functions
 InputData readJsonFile(const string& filename);
+
+// Inserts the instance points, the region boundary and the additional constraints into `cdt`
+void buildTriangulation(const InputData& instance_data, CDT& cdt);
 int countObtuseAngles(const CDT& cdt);
 
+// Obtuse classification of every finite face, from classifyFaces
+struct FaceClassification {
+    vector<CDT::Face_handle> faces;     // finite faces, in iteration order
+    vector<signed char> obtuse_vertex;  // per face: index of its obtuse vertex, -1 if it has none
+    size_t obtuse = 0;                  // faces with an obtuse angle (each has exactly one)
+    size_t cached = 0;                  // known from the face cache
+    size_t filtered = 0;                // settled by the double filter
+    size_t exact = 0;                   // too close to a right angle for it: exact predicate
+};
+
+// Bulk classification: the faces the cache does not know are copied block by block into
+// structure-of-arrays double buffers and classified with branch-free dot-product sign tests
+// under a static error bound (vectorized by the compiler); only faces the bound cannot settle
+// go to CGAL::angle. Fills the face cache. Returns the number of obtuse faces; `result`
+// additionally receives the per-face classification.
+size_t classifyFaces(const CDT& cdt, FaceClassification* result = nullptr);
+
 // Flip Functions
+
+// A flip criterion decides whether the edge (face, edge_index) should be flipped
+typedef bool (*FlipCriterion)(CDT::Face_handle face, int edge_index, const CDT& cdt);
+// Delaunay (in-circle) criterion
 bool shouldFlip(CDT::Face_handle face, int edge_index, const CDT& cdt);
-void performEdgeFlips(CDT& cdt);
+// Flips if the two faces of the edge have fewer obtuse angles afterwards
+bool shouldFlipObtuse(CDT::Face_handle face, int edge_index, const CDT& cdt);
+
+// What a flipping pass changed
+struct FlipReport {
+    int flips = 0;
+    int obtuse_delta = 0;               // change in the number of obtuse angles
+    vector<CDT::Face_handle> faces;     // both faces of every flip (with repeats)
+};
+
+// Queue-driven Lawson flipping: every finite unconstrained edge is queued once, and after
+// a flip only the four edges around the flipped one are queued again. Returns the number of flips.
+int performEdgeFlips(CDT& cdt, FlipCriterion criterion = shouldFlip, FlipReport* report = nullptr);
+// Same, starting from the edges incident to `v` and opposite to it (e.g. after inserting v)
+int performEdgeFlipsAround(CDT& cdt, CDT::Vertex_handle v, FlipCriterion criterion = shouldFlip, FlipReport* report = nullptr);
 
 // Steiner Function
 
+bool obtuseTriangle(const Point& p1, const Point& p2, const Point& p3);
+// Index of the vertex with the obtuse angle of a finite face, or -1; cached in the face info
+int obtuseVertex(CDT::Face_handle face);
 bool obtuseFace(CDT::Face_handle face, const CDT& cdt);
 
-void steinerCircumcenterCentroid(CDT::Face_handle face, CDT& cdt, TriangulationData &data);
-void steinerMedian(CDT::Face_handle face, CDT& cdt, TriangulationData &data);
-void steinerProjection(CDT::Face_handle face, CDT& cdt, TriangulationData &data);
-void centroidPolygon(CDT::Face_handle face, CDT& cdt, TriangulationData &data);
+// Visited marks for one traversal of the faces, in O(1) per face through the face stamps.
+// Each visitor holds its own stamp lane, so traversals on several threads do not interfere;
+// when every lane of the triangulation is taken it falls back to a hash set of the visited faces.
+class FaceVisitor {
+public:
+    explicit FaceVisitor(const CDT& cdt);
+    ~FaceVisitor();
+    FaceVisitor(const FaceVisitor&) = delete;
+    FaceVisitor& operator=(const FaceVisitor&) = delete;
+
+    // Marks `face`; false if this traversal had already visited it
+    bool visit(CDT::Face_handle face);
+    bool visited(CDT::Face_handle face) const;
+
+private:
+    size_t fallbackSlot(const void* face) const;
+
+    const CDT& cdt_;
+    int lane_ = -1;
+    unsigned short stamp_ = 0;
+    vector<const void*> fallback_;
+    size_t fallbackCount_ = 0;
+};
+
+// Nearest point whose coordinates are multiples of 2^-bits (halves rounded up): its exact
+// rationals have denominators of at most 2^bits, however the point was constructed
+Point snapToGrid(const Point& p, int bits);
+
+// A strategy's Steiner point together with where it lies, in the form CDT::locate reports it,
+// so that scoring and insertion can skip point location. Unlocated (null face) when the
+// strategy cannot vouch for the position, e.g. a double point rounded off its edge.
+template <class P>
+struct SteinerCandidate {
+    P point;
+    CDT::Locate_type lt = CDT::FACE;
+    CDT::Face_handle face;   // containing face, or one of the two faces of the containing edge
+    int li = 0;              // the edge (face, li) when lt == EDGE, the vertex when lt == VERTEX
+    size_t strategy = 0;     // index in SteinerStrategies
+
+    bool located() const { return face != CDT::Face_handle(); }
+};
+
+// Each strategy computes its Steiner candidate for the given obtuse face without
+// modifying the triangulation. Returns false if the strategy has no candidate.
+// Instantiated for ExactConstructions, InexactConstructions and IntervalConstructions
+// (which leaves out centroidPolygon's convex hull check: the pre-screen locates the point itself).
+template <class KernelPolicy> bool steinerCircumcenterCentroid(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner);
+template <class KernelPolicy> bool steinerMedian(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner);
+template <class KernelPolicy> bool steinerProjection(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner);
+template <class KernelPolicy> bool centroidPolygon(CDT::Face_handle face, const CDT& cdt, SteinerCandidate<typename KernelPolicy::Candidate>& steiner);
+
+// Candidate Evaluation
+
+// Locates `p` in the hint face or its neighbours with orientation tests, falling back to a
+// serialized CDT::locate walk, so that read-only evaluation can run on several threads.
+CDT::Face_handle locateNear(const CDT& cdt, const Point& p, CDT::Face_handle hint, CDT::Locate_type& lt, int& li);
+
+// Collects the faces that a Delaunay insertion of `steiner` destroys (its conflict region)
+// and the boundary edges of that region, which together with `steiner` form the new faces.
+// The first form locates the point near `hint`, the second takes its location as given.
+void steinerConflictRegion(const CDT& cdt, const Point& steiner, CDT::Face_handle hint,
+                           vector<CDT::Face_handle>& conflicts, vector<CDT::Edge>& boundary);
+void steinerConflictRegion(const CDT& cdt, const Point& steiner, CDT::Locate_type lt, CDT::Face_handle loc, int li,
+                           vector<CDT::Face_handle>& conflicts, vector<CDT::Edge>& boundary);
+
+// Change in the number of obtuse angles if `steiner` were inserted, computed only over
+// its conflict region (created faces minus destroyed faces). Negative means improvement.
+int regionObtuseDelta(const CDT& cdt, const Point& steiner,
+                      const vector<CDT::Face_handle>& conflicts, const vector<CDT::Edge>& boundary);
+int steinerObtuseDelta(const CDT& cdt, const Point& steiner, CDT::Face_handle hint = CDT::Face_handle());
+
+// regionObtuseDelta for an interval candidate, in double arithmetic: true if every test was
+// certain, and then `delta` is exactly what the exact evaluation of the candidate would give.
+// False when the box cannot be placed strictly inside `hint` or a neighbour, or a test is uncertain.
+bool intervalObtuseDelta(const CDT& cdt, const IntervalConstructions::Candidate& steiner, CDT::Face_handle hint, int& delta);
+
+// Exact change in the number of obtuse angles caused by a logged (tentative) insertion
+int insertionObtuseDelta(const CDT& cdt, const CDT::Insert_record& record);
+
+// Worklist of obtuse faces for the improvement loop. Faces are keyed by their vertices,
+// since insertions delete face handles; entries that are no longer faces are skipped on pop.
+class ObtuseWorklist {
+public:
+    void seed(const CDT& cdt);
+    void seed(const CDT& cdt, const vector<CDT::Face_handle>& faces); // only the obtuse ones of `faces`
+    bool pop(const CDT& cdt, CDT::Face_handle& face);
+    void push(const CDT& cdt, CDT::Face_handle face);
+    void update(const CDT& cdt, CDT::Vertex_handle steiner);
+
+    bool empty() const { return queue_.empty(); }
+    size_t size() const { return queue_.size(); }
+
+private:
+    typedef array<CDT::Vertex_handle, 3> FaceKey;
+
+    deque<FaceKey> queue_;
+    set<FaceKey> queued_;
+};
 
 // Output the data to a JSON file
+// Edges refer to vertices by their info().id; vertices without one (e.g. constraint
+// intersections) get the next Steiner index and are written after `steiner_points`.
 string print_rational(const K::FT& coord);
 void writeJsonOutput(const string& output_filename, const string& instance_uid, const vector<Point>& steiner_points, const CDT& finalCDT);
+// Compact binary variant for internal pipelines:
+//   "CGSB" u32 version=1, u32 uid length + bytes, u64 steiner count, per coordinate (x then y)
+//   u32 length + "num/den" text, u64 edge count, then u32 index pairs, all little-endian
+void writeBinaryOutput(const string& output_filename, const string& instance_uid, const vector<Point>& steiner_points, const CDT& finalCDT);
 
 #endif // UTILS_HPP
\ No newline at end of file
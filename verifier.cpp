@@ -0,0 +1,654 @@
+#include "utils.hpp"
+#include "json_reader.hpp"
+#include "solver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+
+#include <gmpxx.h>
+
+using namespace std;
+
+// Independent check of a solution file against its instance.
+// Usage: verifier instance.json solution.json [--threads N] [--max-reports N]
+// The triangulation is rebuilt from the listed edges alone (no CGAL triangulation) and checked for:
+//   - valid indices, no duplicate points, no isolated points, no duplicate or overlapping edges;
+//   - planarity: around every vertex the edges are sorted by angle, every bounded face traced
+//     from that rotation must be a counter-clockwise triangle, and there must be exactly one
+//     unbounded face, a simple cycle that is convex or the region boundary itself. These make the
+//     straight-line drawing an embedding, so no two edges cross and the triangles tile their hull;
+//   - every region_boundary and additional_constraints segment is a chain of solution edges;
+//   - the triangles enclosed by the region boundary: coverage, and how many of them are obtuse.
+// Predicates are evaluated in double precision with an error bound and redone with exact
+// rationals only when the sign is uncertain. Exit code 0 if valid, 1 if not, 2 if unreadable.
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+struct Solution {
+    string instance_uid;
+    vector<mpq_class> steiner_x, steiner_y;
+    vector<array<int, 2>> edges;
+};
+
+// A coordinate is an integer or a string holding an integer or "numerator/denominator"
+mpq_class readCoordinate(JsonReader& reader) {
+    if (reader.peek() != '"') {
+        return mpq_class(static_cast<long>(reader.readInteger()));
+    }
+    size_t start = reader.offset();
+    string text = reader.readString();
+    mpq_class value;
+    if (text.empty() || value.set_str(text, 10) != 0 || value.get_den() == 0) {
+        throw JsonError("invalid rational \"" + text + "\"", start);
+    }
+    value.canonicalize();
+    return value;
+}
+
+bool readSolution(const string& filename, Solution& solution) {
+    try {
+        JsonReader reader(filename);
+        reader.readObject([&](const string& key) {
+            if (key == "instance_uid") {
+                solution.instance_uid = reader.readString();
+            } else if (key == "steiner_points_x") {
+                reader.readArray([&] { solution.steiner_x.push_back(readCoordinate(reader)); });
+            } else if (key == "steiner_points_y") {
+                reader.readArray([&] { solution.steiner_y.push_back(readCoordinate(reader)); });
+            } else if (key == "edges") {
+                vector<int> edge;
+                reader.readArray([&] {
+                    size_t start = reader.offset();
+                    edge.clear();
+                    reader.readIntArray(edge);
+                    if (edge.size() != 2) {
+                        throw JsonError("an edge must have two vertex indices", start);
+                    }
+                    solution.edges.push_back({edge[0], edge[1]});
+                });
+            } else {
+                reader.skipValue();
+            }
+        });
+        if (!reader.atEnd()) {
+            reader.fail("unexpected data after the top-level object");
+        }
+        if (solution.steiner_x.size() != solution.steiner_y.size()) {
+            throw JsonError("steiner_points_x and steiner_points_y differ in length", reader.offset());
+        }
+    } catch (const JsonError& e) {
+        cerr << "Error reading solution " << filename << ": " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+// Violations found by any thread; only the first `limit` are kept for printing
+class Report {
+public:
+    explicit Report(size_t limit) : limit_(limit) {}
+
+    void add(const string& message) {
+        lock_guard<mutex> lock(mutex_);
+        if (messages_.size() < limit_) {
+            messages_.push_back(message);
+        }
+        ++count_;
+    }
+    size_t count() {
+        lock_guard<mutex> lock(mutex_);
+        return count_;
+    }
+    void print(ostream& out) {
+        lock_guard<mutex> lock(mutex_);
+        for (const string& message : messages_) {
+            out << "violation: " << message << "\n";
+        }
+        if (count_ > messages_.size()) {
+            out << "... and " << count_ - messages_.size() << " more violations\n";
+        }
+    }
+
+private:
+    mutex mutex_;
+    vector<string> messages_;
+    size_t count_ = 0;
+    size_t limit_;
+};
+
+// Filtered predicates over the point set, in three stages: the double approximations decide
+// whenever the error bound allows it; signs they cannot settle (typically exact zeros: collinear
+// points, right angles) are computed exactly in 128-bit integers when the three points have
+// integer coordinates, and with rationals otherwise
+class Geometry {
+public:
+    Geometry(vector<mpq_class> xs, vector<mpq_class> ys) : ex_(move(xs)), ey_(move(ys)) {
+        x_.resize(ex_.size());
+        y_.resize(ey_.size());
+        ix_.resize(ex_.size());
+        iy_.resize(ey_.size());
+        integral_.resize(ex_.size());
+        for (size_t i = 0; i < ex_.size(); ++i) {
+            x_[i] = ex_[i].get_d();
+            y_[i] = ey_[i].get_d();
+            // Differences of such coordinates fit in 63 bits and their products in 127
+            integral_[i] = ex_[i].get_den() == 1 && ey_[i].get_den() == 1 && fabs(x_[i]) < kIntegralLimit && fabs(y_[i]) < kIntegralLimit;
+            if (integral_[i]) {
+                ix_[i] = static_cast<int64_t>(x_[i]);
+                iy_[i] = static_cast<int64_t>(y_[i]);
+            }
+        }
+    }
+
+    size_t size() const { return ex_.size(); }
+    // Predicates that needed rational arithmetic
+    size_t exactEvaluations() const { return exact_.load(memory_order_relaxed); }
+
+    // Sign of the orientation of (a, b, c): 1 counter-clockwise, -1 clockwise, 0 collinear
+    int orientation(int a, int b, int c) const {
+        double det = (x_[b] - x_[a]) * (y_[c] - y_[a]) - (y_[b] - y_[a]) * (x_[c] - x_[a]);
+        double magnitude = (fabs(x_[a]) + fabs(x_[b])) * (fabs(y_[a]) + fabs(y_[c]))
+                         + (fabs(y_[a]) + fabs(y_[b])) * (fabs(x_[a]) + fabs(x_[c]));
+        int sign = filtered(det, magnitude);
+        if (sign != kUncertain) {
+            return sign;
+        }
+        if (integral_[a] && integral_[b] && integral_[c]) {
+            __int128 exact = static_cast<__int128>(ix_[b] - ix_[a]) * (iy_[c] - iy_[a])
+                           - static_cast<__int128>(iy_[b] - iy_[a]) * (ix_[c] - ix_[a]);
+            return (exact > 0) - (exact < 0);
+        }
+        exact_.fetch_add(1, memory_order_relaxed);
+        mpq_class exact = (ex_[b] - ex_[a]) * (ey_[c] - ey_[a]) - (ey_[b] - ey_[a]) * (ex_[c] - ex_[a]);
+        return sgn(exact);
+    }
+
+    // Sign of (b - a) . (c - a): negative iff the angle at a is obtuse
+    int dot(int a, int b, int c) const {
+        double value = (x_[b] - x_[a]) * (x_[c] - x_[a]) + (y_[b] - y_[a]) * (y_[c] - y_[a]);
+        double magnitude = (fabs(x_[a]) + fabs(x_[b])) * (fabs(x_[a]) + fabs(x_[c]))
+                         + (fabs(y_[a]) + fabs(y_[b])) * (fabs(y_[a]) + fabs(y_[c]));
+        int sign = filtered(value, magnitude);
+        if (sign != kUncertain) {
+            return sign;
+        }
+        if (integral_[a] && integral_[b] && integral_[c]) {
+            __int128 exact = static_cast<__int128>(ix_[b] - ix_[a]) * (ix_[c] - ix_[a])
+                           + static_cast<__int128>(iy_[b] - iy_[a]) * (iy_[c] - iy_[a]);
+            return (exact > 0) - (exact < 0);
+        }
+        exact_.fetch_add(1, memory_order_relaxed);
+        mpq_class exact = (ex_[b] - ex_[a]) * (ex_[c] - ex_[a]) + (ey_[b] - ey_[a]) * (ey_[c] - ey_[a]);
+        return sgn(exact);
+    }
+
+    // Rounding is monotone, so different approximations order the exact values too
+    int compareX(int a, int b) const {
+        return x_[a] != x_[b] ? (x_[a] < x_[b] ? -1 : 1) : cmp(ex_[a], ex_[b]);
+    }
+    int compareY(int a, int b) const {
+        return y_[a] != y_[b] ? (y_[a] < y_[b] ? -1 : 1) : cmp(ey_[a], ey_[b]);
+    }
+
+    // Angular order of the directions a - v and b - v, starting from the positive x axis
+    bool angleLess(int v, int a, int b) const {
+        int ha = halfPlane(v, a), hb = halfPlane(v, b);
+        if (ha != hb) {
+            return ha < hb;
+        }
+        return orientation(v, a, b) > 0;
+    }
+    bool sameDirection(int v, int a, int b) const {
+        return halfPlane(v, a) == halfPlane(v, b) && orientation(v, a, b) == 0;
+    }
+
+    // w lies strictly inside the segment (v, b)
+    bool strictlyBetween(int v, int w, int b) const {
+        return orientation(v, b, w) == 0 && dot(v, w, b) > 0 && dot(b, w, v) > 0;
+    }
+
+    string describe(int v) const {
+        return to_string(v) + " (" + ex_[v].get_str() + ", " + ey_[v].get_str() + ")";
+    }
+
+private:
+    static const int kUncertain = 2;
+    static constexpr double kIntegralLimit = 4611686018427387904.0; // 2^62
+
+    // The inputs are within one ulp of the exact values; 8 epsilons of the magnitude of the
+    // terms bound the input error and the rounding of the three operations with a wide margin
+    static int filtered(double value, double magnitude) {
+        if (!(magnitude < 1e300) || magnitude < 1e-280) {
+            return kUncertain;
+        }
+        double bound = 8 * numeric_limits<double>::epsilon() * magnitude;
+        if (value > bound) {
+            return 1;
+        }
+        if (value < -bound) {
+            return -1;
+        }
+        return kUncertain;
+    }
+
+    // 0 for directions in [0, pi), 1 for [pi, 2 pi)
+    int halfPlane(int v, int a) const {
+        int dy = compareY(a, v);
+        return (dy > 0 || (dy == 0 && compareX(a, v) > 0)) ? 0 : 1;
+    }
+
+    vector<mpq_class> ex_, ey_;
+    vector<double> x_, y_;
+    vector<int64_t> ix_, iy_;
+    vector<char> integral_;
+    mutable atomic<size_t> exact_{0};
+};
+
+// Runs body(begin, end) over [0, count) in chunks on the pool
+template <class Body>
+void parallelFor(WorkerPool& pool, size_t count, Body&& body) {
+    size_t chunks = min<size_t>(count, static_cast<size_t>(pool.size()) * 8);
+    if (chunks == 0) {
+        return;
+    }
+    pool.run(chunks, [&](size_t chunk) {
+        body(count * chunk / chunks, count * (chunk + 1) / chunks);
+    });
+}
+
+// Planar map of the solution: half-edge h goes from origin[h] to target[h]; the half-edges
+// leaving v are [offset[v], offset[v + 1]), sorted counter-clockwise by angle
+struct PlanarMap {
+    vector<size_t> offset;
+    vector<int> origin, target;
+    vector<size_t> twin, next;
+
+    size_t halfEdges() const { return target.size(); }
+};
+
+// Chain of solution edges covering the segment (a, b), as half-edges from a to b; empty if there is none
+vector<size_t> segmentChain(const PlanarMap& map, const Geometry& geometry, int a, int b) {
+    vector<size_t> chain;
+    int v = a;
+    while (v != b) {
+        size_t step = map.halfEdges();
+        for (size_t h = map.offset[v]; h < map.offset[v + 1]; ++h) {
+            int w = map.target[h];
+            if (w == b || geometry.strictlyBetween(v, w, b)) {
+                step = h;
+                break;
+            }
+        }
+        if (step == map.halfEdges()) {
+            return {};
+        }
+        chain.push_back(step);
+        v = map.target[step];
+    }
+    return chain;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    string instanceFile, solutionFile;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    size_t maxReports = 20;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(max(1, atoi(argv[++i])));
+        } else if (arg == "--max-reports" && i + 1 < argc) {
+            maxReports = static_cast<size_t>(atol(argv[++i]));
+        } else if (instanceFile.empty()) {
+            instanceFile = arg;
+        } else if (solutionFile.empty()) {
+            solutionFile = arg;
+        } else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 2;
+        }
+    }
+    if (solutionFile.empty()) {
+        cerr << "Usage: verifier instance.json solution.json [--threads N] [--max-reports N]" << endl;
+        return 2;
+    }
+
+    //////////////////// Read both files ////////////////////
+    auto start = chrono::steady_clock::now();
+    InputData instance = readJsonFile(instanceFile);
+    if (instance.getPointsX().empty()) {
+        cerr << "Instance " << instanceFile << " has no points" << endl;
+        return 2;
+    }
+    Solution solution;
+    if (!readSolution(solutionFile, solution)) {
+        return 2;
+    }
+    double readSeconds = secondsSince(start);
+    start = chrono::steady_clock::now();
+
+    Report report(maxReports);
+    if (solution.instance_uid != instance.getInstanceUid()) {
+        report.add("solution is for instance \"" + solution.instance_uid + "\", not \"" + instance.getInstanceUid() + "\"");
+    }
+
+    const size_t inputPoints = instance.getPointsX().size();
+    vector<mpq_class> xs, ys;
+    xs.reserve(inputPoints + solution.steiner_x.size());
+    ys.reserve(inputPoints + solution.steiner_y.size());
+    for (size_t i = 0; i < inputPoints; ++i) {
+        xs.emplace_back(instance.getPointsX()[i]);
+        ys.emplace_back(instance.getPointsY()[i]);
+    }
+    xs.insert(xs.end(), solution.steiner_x.begin(), solution.steiner_x.end());
+    ys.insert(ys.end(), solution.steiner_y.begin(), solution.steiner_y.end());
+    const Geometry geometry(move(xs), move(ys));
+    const size_t n = geometry.size();
+    WorkerPool pool(threads);
+
+    // Verdict for the structural checks, after which the later ones are meaningless
+    auto finish = [&](int obtuse, size_t triangles, size_t outside) {
+        report.print(cout);
+        size_t violations = report.count();
+        cout << "instance: " << instance.getInstanceUid() << "\n"
+             << "points: " << inputPoints << " input + " << n - inputPoints << " Steiner, edges: " << solution.edges.size() << "\n";
+        if (obtuse >= 0) {
+            cout << "triangles in the region: " << triangles << ", obtuse: " << obtuse << "\n"
+                 << "triangles outside the region: " << outside << "\n";
+        }
+        cout << "rational predicate evaluations: " << geometry.exactEvaluations() << "\n"
+             << "read: " << readSeconds << " s, check: " << secondsSince(start) << " s\n"
+             << (violations == 0 ? "valid" : "INVALID (" + to_string(violations) + " violations)") << endl;
+        return violations == 0 ? 0 : 1;
+    };
+
+    //////////////////// Points and edges ////////////////////
+    {
+        vector<int> order(n);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](int a, int b) {
+            int cx = geometry.compareX(a, b);
+            return cx != 0 ? cx < 0 : geometry.compareY(a, b) < 0;
+        });
+        for (size_t i = 1; i < n; ++i) {
+            if (geometry.compareX(order[i - 1], order[i]) == 0 && geometry.compareY(order[i - 1], order[i]) == 0) {
+                report.add("points " + geometry.describe(order[i - 1]) + " and " + to_string(order[i]) + " coincide");
+            }
+        }
+    }
+
+    PlanarMap map;
+    map.offset.assign(n + 1, 0);
+    for (const auto& edge : solution.edges) {
+        if (edge[0] < 0 || edge[1] < 0 || static_cast<size_t>(edge[0]) >= n || static_cast<size_t>(edge[1]) >= n) {
+            report.add("edge [" + to_string(edge[0]) + ", " + to_string(edge[1]) + "] refers to a missing point");
+        } else if (edge[0] == edge[1]) {
+            report.add("edge [" + to_string(edge[0]) + ", " + to_string(edge[1]) + "] is a loop");
+        } else {
+            ++map.offset[edge[0] + 1];
+            ++map.offset[edge[1] + 1];
+        }
+    }
+    if (report.count() > 0) {
+        return finish(-1, 0, 0);
+    }
+    for (size_t v = 0; v < n; ++v) {
+        if (map.offset[v + 1] == 0) {
+            report.add("point " + geometry.describe(static_cast<int>(v)) + " is not on any edge");
+        }
+        map.offset[v + 1] += map.offset[v];
+    }
+    map.origin.resize(map.offset[n]);
+    map.target.resize(map.offset[n]);
+    {
+        vector<size_t> fill(map.offset.begin(), map.offset.end() - 1);
+        for (const auto& edge : solution.edges) {
+            map.origin[fill[edge[0]]] = edge[0];
+            map.target[fill[edge[0]]++] = edge[1];
+            map.origin[fill[edge[1]]] = edge[1];
+            map.target[fill[edge[1]]++] = edge[0];
+        }
+    }
+
+    // Rotation system: the edges around each vertex by angle; equal directions mean a
+    // duplicate edge or two overlapping ones
+    parallelFor(pool, n, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            int center = static_cast<int>(v);
+            auto first = map.target.begin() + map.offset[v], last = map.target.begin() + map.offset[v + 1];
+            sort(first, last, [&](int a, int b) { return geometry.angleLess(center, a, b); });
+            for (auto it = first; it != last && next(it) != last; ++it) {
+                if (geometry.sameDirection(center, *it, *next(it))) {
+                    report.add(*it == *next(it)
+                        ? "edge [" + to_string(v) + ", " + to_string(*it) + "] is listed twice"
+                        : "edges [" + to_string(v) + ", " + to_string(*it) + "] and [" + to_string(v) + ", " + to_string(*next(it)) + "] overlap");
+                }
+            }
+        }
+    });
+    if (report.count() > 0) {
+        return finish(-1, 0, 0);
+    }
+
+    // twin by binary search in an id-ordered copy of each rotation; next(u -> v) = v -> the
+    // neighbour of v just before u in counter-clockwise order, which keeps the face on the left
+    const size_t halfEdges = map.halfEdges();
+    vector<size_t> byTarget(halfEdges);
+    iota(byTarget.begin(), byTarget.end(), size_t(0));
+    parallelFor(pool, n, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            sort(byTarget.begin() + map.offset[v], byTarget.begin() + map.offset[v + 1],
+                 [&](size_t a, size_t b) { return map.target[a] < map.target[b]; });
+        }
+    });
+    map.twin.resize(halfEdges);
+    map.next.resize(halfEdges);
+    parallelFor(pool, halfEdges, [&](size_t begin, size_t end) {
+        for (size_t h = begin; h < end; ++h) {
+            int u = map.origin[h], v = map.target[h];
+            auto first = byTarget.begin() + map.offset[v], last = byTarget.begin() + map.offset[v + 1];
+            size_t twin = *lower_bound(first, last, u, [&](size_t e, int id) { return map.target[e] < id; });
+            map.twin[h] = twin;
+            size_t degree = map.offset[v + 1] - map.offset[v];
+            map.next[h] = map.offset[v] + (twin - map.offset[v] + degree - 1) % degree;
+        }
+    });
+
+    //////////////////// Faces ////////////////////
+    // A triangle is identified by its smallest half-edge; face[h] is that half-edge, or
+    // `open` for the half-edges of faces that are not counter-clockwise triangles
+    const size_t open = halfEdges;
+    vector<size_t> face(halfEdges);
+    parallelFor(pool, halfEdges, [&](size_t begin, size_t end) {
+        for (size_t h = begin; h < end; ++h) {
+            size_t h2 = map.next[h], h3 = map.next[h2];
+            face[h] = open;
+            if (map.next[h3] != h) {
+                continue;
+            }
+            size_t first = min(h, min(h2, h3));
+            int sign = geometry.orientation(map.origin[h], map.origin[h2], map.origin[h3]);
+            if (sign > 0) {
+                face[h] = first;
+            } else if (sign == 0 && h == first) {
+                report.add("triangle " + to_string(map.origin[h]) + ", " + to_string(map.origin[h2]) + ", "
+                           + to_string(map.origin[h3]) + " is degenerate");
+            }
+        }
+    });
+
+    // Everything that is not a counter-clockwise triangle must be one single face, the unbounded one
+    vector<vector<size_t>> openFaces;
+    {
+        vector<char> traced(halfEdges, 0);
+        for (size_t h = 0; h < halfEdges; ++h) {
+            if (face[h] != open || traced[h]) {
+                continue;
+            }
+            openFaces.emplace_back();
+            for (size_t e = h; !traced[e]; e = map.next[e]) {
+                traced[e] = 1;
+                openFaces.back().push_back(e);
+            }
+        }
+    }
+    if (openFaces.size() != 1) {
+        for (const auto& cycle : openFaces) {
+            report.add("face through " + geometry.describe(map.origin[cycle[0]]) + " with " + to_string(cycle.size())
+                       + " edges is not a counter-clockwise triangle");
+        }
+        if (openFaces.empty()) {
+            report.add("the edges leave no unbounded face");
+        }
+        return finish(-1, 0, 0);
+    }
+    const vector<size_t>& outer = openFaces[0];
+
+    //////////////////// Region boundary and constraints ////////////////////
+    // The boundary is walked with the region on the left; inner[h] marks its half-edges
+    vector<int> boundary = instance.getRegionBoundary();
+    if (boundary.size() < 3) {
+        report.add("region_boundary has fewer than 3 points");
+        return finish(-1, 0, 0);
+    }
+    {
+        mpq_class area = 0;
+        for (size_t i = 0; i < boundary.size(); ++i) {
+            int a = boundary[i], b = boundary[(i + 1) % boundary.size()];
+            area += mpq_class(instance.getPointsX()[a]) * instance.getPointsY()[b]
+                  - mpq_class(instance.getPointsX()[b]) * instance.getPointsY()[a];
+        }
+        if (area < 0) {
+            reverse(boundary.begin(), boundary.end());
+        }
+    }
+    vector<char> inner(halfEdges, 0);
+    vector<vector<size_t>> boundaryChains(boundary.size());
+    parallelFor(pool, boundary.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            int a = boundary[i], b = boundary[(i + 1) % boundary.size()];
+            boundaryChains[i] = segmentChain(map, geometry, a, b);
+            if (boundaryChains[i].empty()) {
+                report.add("region boundary segment " + to_string(a) + "-" + to_string(b) + " is not covered by edges");
+            }
+        }
+    });
+    for (const auto& chain : boundaryChains) {
+        for (size_t h : chain) {
+            inner[h] = 1;
+        }
+    }
+    const auto& constraints = instance.getAdditionalConstraints();
+    parallelFor(pool, constraints.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t k = 1; k < constraints[i].size(); ++k) {
+                int a = constraints[i][k - 1], b = constraints[i][k];
+                if (segmentChain(map, geometry, a, b).empty()) {
+                    report.add("constraint " + to_string(a) + "-" + to_string(b) + " is not covered by edges");
+                }
+            }
+        }
+    });
+
+    // The unbounded face must be a simple cycle, convex (the hull of the points) or exactly the
+    // region boundary seen from outside; otherwise the drawing may wrap around itself
+    {
+        vector<char> seen(n, 0);
+        bool simple = true, convex = true, regionOnly = true;
+        for (size_t k = 0; k < outer.size(); ++k) {
+            size_t h = outer[k], following = outer[(k + 1) % outer.size()];
+            simple = simple && !seen[map.origin[h]];
+            seen[map.origin[h]] = 1;
+            convex = convex && geometry.orientation(map.origin[h], map.target[h], map.target[following]) <= 0;
+            regionOnly = regionOnly && inner[map.twin[h]];
+        }
+        if (!simple || !(convex || regionOnly)) {
+            report.add("the outer boundary of the edges through " + geometry.describe(map.origin[outer[0]])
+                       + " is not a simple convex cycle nor the region boundary: the drawing is not planar");
+        }
+    }
+    if (report.count() > 0) {
+        return finish(-1, 0, 0);
+    }
+
+    //////////////////// Region coverage and obtuse triangles ////////////////////
+    // Triangles reachable from the inner side of the boundary without crossing it; reaching the
+    // unbounded face would mean the boundary chains do not enclose a region
+    vector<char> inRegion(halfEdges, 0);
+    {
+        vector<size_t> stack;
+        bool leaked = false;
+        for (const auto& chain : boundaryChains) {
+            for (size_t h : chain) {
+                if (face[h] == open) {
+                    leaked = true;
+                } else if (!inRegion[face[h]]) {
+                    inRegion[face[h]] = 1;
+                    stack.push_back(face[h]);
+                }
+            }
+        }
+        while (!stack.empty() && !leaked) {
+            size_t first = stack.back();
+            stack.pop_back();
+            size_t h = first;
+            do {
+                if (!inner[h] && !inner[map.twin[h]]) {
+                    size_t other = face[map.twin[h]];
+                    if (other == open) {
+                        leaked = true;
+                    } else if (!inRegion[other]) {
+                        inRegion[other] = 1;
+                        stack.push_back(other);
+                    }
+                }
+                h = map.next[h];
+            } while (h != first);
+        }
+        if (leaked) {
+            report.add("the region boundary does not enclose the triangles inside it");
+            return finish(-1, 0, 0);
+        }
+    }
+
+    vector<size_t> triangles;
+    for (size_t h = 0; h < halfEdges; ++h) {
+        if (face[h] == h) {
+            triangles.push_back(h);
+        }
+    }
+    atomic<int> obtuse{0};
+    atomic<size_t> inside{0};
+    parallelFor(pool, triangles.size(), [&](size_t begin, size_t end) {
+        int localObtuse = 0;
+        size_t localInside = 0;
+        for (size_t i = begin; i < end; ++i) {
+            size_t h = triangles[i];
+            if (!inRegion[h]) {
+                continue;
+            }
+            ++localInside;
+            int a = map.origin[h], b = map.origin[map.next[h]], c = map.target[map.next[h]];
+            if (geometry.dot(a, b, c) < 0 || geometry.dot(b, c, a) < 0 || geometry.dot(c, a, b) < 0) {
+                ++localObtuse;
+            }
+        }
+        obtuse += localObtuse;
+        inside += localInside;
+    });
+    if (inside == 0) {
+        report.add("no triangle lies inside the region boundary");
+    }
+    return finish(obtuse, inside, triangles.size() - inside);
+}